@@ -0,0 +1,99 @@
+// common/include/boottrace.h
+// Boot-stage timing shared by the stub and the forwarder; both Makefiles add
+// common/include to their include path. Each component marks the end of every
+// stage with svcGetSystemTick(); the result can be logged as one compact line
+// and/or appended as a fixed-size record to BOOTTRACE_PATH.
+// tools/latency_report.py aggregates those records across titles.
+#pragma once
+
+#include <switch.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>   // mkdir
+
+#define BOOTTRACE_DIR        "sdmc:/switch-rom-packer"
+#define BOOTTRACE_PATH       BOOTTRACE_DIR "/boot-trace.bin"
+#define BOOTTRACE_MAGIC      "SRPT"
+#define BOOTTRACE_VERSION    1
+#define BOOTTRACE_MAX_STAGES 12
+
+enum { BOOTTRACE_FORWARDER = 0, BOOTTRACE_STUB = 1 };
+
+// Stage indices; keep in sync with STAGES in tools/latency_report.py.
+enum {
+    FWD_STAGE_FS_INIT,       // fsInitialize
+    FWD_STAGE_SDMC_MOUNT,    // fsdevMountSdmc
+    FWD_STAGE_ROMFS_INIT,    // romfsInit
+    FWD_STAGE_READ_PARAMS,   // launch parameters from RomFS
+    FWD_STAGE_STAT_TARGET,   // stat() of the target NRO and core candidates
+    FWD_STAGE_HANDOFF,       // envSetNextLoad
+    FWD_STAGE_COUNT
+};
+
+enum {
+    STUB_STAGE_CONSOLE_INIT, // consoleInit
+    STUB_STAGE_ROMFS_INIT,   // romfsInit
+    STUB_STAGE_LOAD,         // manifest read
+    STUB_STAGE_VALIDATE,     // manifest header checks
+    STUB_STAGE_EXTRACT,      // extractAll
+    STUB_STAGE_COUNT
+};
+
+typedef struct __attribute__((packed)) {
+    char magic[4];                          // "SRPT"
+    u16  version;
+    u8   component;                         // BOOTTRACE_FORWARDER / BOOTTRACE_STUB
+    u8   stage_count;                       // stages actually reached
+    u64  program_id;
+    u64  start_tick;                        // system tick at main() entry
+    u32  stage_us[BOOTTRACE_MAX_STAGES];    // duration of each stage in microseconds
+    u32  status;                            // 0 on success, else component error code
+    u32  reserved;
+} BootTraceRecord;
+
+_Static_assert(sizeof(BootTraceRecord) == 80, "BootTraceRecord layout");
+
+typedef struct {
+    BootTraceRecord rec;
+    u64             last;
+} BootTrace;
+
+static inline void bootTraceBegin(BootTrace* t, u8 component) {
+    memset(t, 0, sizeof(*t));
+    t->last = svcGetSystemTick();
+    memcpy(t->rec.magic, BOOTTRACE_MAGIC, 4);
+    t->rec.version    = BOOTTRACE_VERSION;
+    t->rec.component  = component;
+    t->rec.start_tick = t->last;
+    u64 programId = 0;
+    svcGetInfo(&programId, InfoType_ProgramId, CUR_PROCESS_HANDLE, 0);
+    t->rec.program_id = programId;
+}
+
+// Close `stage`: everything since the previous mark is charged to it.
+static inline void bootTraceMark(BootTrace* t, u32 stage) {
+    u64 now = svcGetSystemTick();
+    if (stage < BOOTTRACE_MAX_STAGES) {
+        t->rec.stage_us[stage] = (u32)(armTicksToNs(now - t->last) / 1000);
+        if (stage + 1 > t->rec.stage_count) t->rec.stage_count = (u8)(stage + 1);
+    }
+    t->last = now;
+}
+
+// "boot total=<us> s0=<us> s1=<us> ..." for logs and the console.
+static inline void bootTraceFormat(const BootTrace* t, char* out, size_t outsz) {
+    u64 total = 0;
+    for (u32 i = 0; i < t->rec.stage_count; i++) total += t->rec.stage_us[i];
+    int n = snprintf(out, outsz, "boot total=%lluus", (unsigned long long)total);
+    for (u32 i = 0; i < t->rec.stage_count && n > 0 && (size_t)n < outsz; i++)
+        n += snprintf(out + n, outsz - n, " s%u=%u", (unsigned)i, (unsigned)t->rec.stage_us[i]);
+}
+
+// Append the record to BOOTTRACE_PATH with a single open. Best effort.
+static inline void bootTraceWrite(const BootTrace* t) {
+    mkdir(BOOTTRACE_DIR, 0777);
+    FILE* f = fopen(BOOTTRACE_PATH, "ab");
+    if (!f) return;
+    fwrite(&t->rec, sizeof(t->rec), 1, f);
+    fclose(f);
+}
@@ -0,0 +1,56 @@
+// forwarder/include/launch.h
+// Launch descriptor (romfs:/launch.bin) written by packer/build/launch.py.
+// All fields are little-endian; strings live in a NUL-terminated string table.
+#pragma once
+
+#include <stdint.h>
+
+#define LAUNCH_FILE     "launch.bin"
+#define LAUNCH_MAGIC    "SRPL"
+#define LAUNCH_VERSION  2
+
+#define LAUNCH_FLAG_VERBOSE_LOG 0x0001  // log at info level regardless of LOG_LEVEL
+#define LAUNCH_FLAG_TRACE       0x0002  // append a boot trace record (as with TRACE=1)
+
+// Sanity cap on the descriptor size; real ones are a few hundred bytes.
+#define LAUNCH_MAX_SIZE (64 * 1024)
+
+typedef struct {
+    char     magic[4];
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t total_size;
+    uint32_t flags;
+    uint32_t target_off;       // NRO to chainload
+    uint32_t argc;             // arguments after argv[0]
+    uint32_t argv_offset;      // u32[argc] strtab offsets
+    uint32_t fallback_count;   // alternative NROs, tried in order
+    uint32_t fallback_offset;  // u32[fallback_count] strtab offsets
+    uint32_t strtab_offset;
+    uint32_t strtab_size;
+    // v2+: ordered core candidates; the first one present on the SD card
+    // replaces argv[core_arg]
+    uint32_t core_count;
+    uint32_t core_offset;      // u32[core_count] strtab offsets
+    uint32_t core_arg;
+} __attribute__((packed)) LaunchHeader;
+
+#define LAUNCH_HEADER_V1_SIZE 44
+
+_Static_assert(sizeof(LaunchHeader) == 56, "LaunchHeader layout");
+
+// Per-title descriptor slot in .rodata. packer/build/nso.py finds it by tag in
+// a copy of exefs/main and fills size/data, so the NSP needs no RomFS. size == 0
+// means the NSO was not patched and the forwarder reads romfs:/launch.bin.
+// The tag must only ever appear in the slot's initializer.
+#define LAUNCH_EMBED_TAG  "SRP-LAUNCH-SLOT"   // 15 chars + NUL = 16 bytes
+#define LAUNCH_EMBED_SIZE 4096
+
+typedef struct {
+    char     tag[16];
+    uint32_t size;
+    uint32_t reserved[3];
+    uint8_t  data[LAUNCH_EMBED_SIZE];
+} __attribute__((packed)) LaunchEmbed;
+
+_Static_assert(sizeof(LaunchEmbed) == 32 + LAUNCH_EMBED_SIZE, "LaunchEmbed layout");
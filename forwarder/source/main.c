@@ -6,85 +6,244 @@
 #include <stdarg.h>
 #include <sys/stat.h>   // mkdir
 
-#define LOG_DIR   "sdmc:/switch-rom-packer"
-#define LOG_PATH  LOG_DIR "/forwarder.log"
-#define ARG_FILE  "romfs:/nextArgv"
-#define NRO_FILE  "romfs:/nextNroPath"
+#include "boottrace.h"
+#include "launch.h"
+
+#define LOG_DIR     "sdmc:/switch-rom-packer"
+#define LOG_PATH    LOG_DIR "/forwarder.log"
+#define LAUNCH_PATH "romfs:/" LAUNCH_FILE
+
+// Log levels. Lines above the current level are compiled in but dropped at
+// runtime; at LOG_NONE nothing ever touches the SD card. The level comes from
+// `make LOG_LEVEL=<n>` and can be raised per title with LAUNCH_FLAG_VERBOSE_LOG.
+#define LOG_NONE  0
+#define LOG_ERROR 1
+#define LOG_INFO  2
+
+#ifndef SRP_LOG_LEVEL
+#define SRP_LOG_LEVEL LOG_ERROR
+#endif
+
+#define LOG_BUF_SIZE 4096
+
+// Binary boot-stage records (boottrace.h) are only written when built with
+// `make TRACE=1`; the timing line is always available at LOG_INFO.
+#ifndef SRP_TRACE
+#define SRP_TRACE 0
+#endif
+
+// BootTraceRecord.status values
+enum { FWD_OK, FWD_ERR_NO_PARAMS, FWD_ERR_NO_TARGET, FWD_ERR_CHAINLOAD, FWD_ERR_NO_CORE };
+
+// Launch descriptor loaded in one read; all strings point into data.
+typedef struct {
+    u8*                 data;
+    const LaunchHeader* hdr;
+    u32                 coreCount;   // 0 for v1 descriptors
+    const char*         core;        // chosen candidate, substituted for argv[hdr->core_arg]
+} Launch;
+
+static int g_logLevel = SRP_LOG_LEVEL;
 
 // -------- logging helpers --------
-static void ensure_log_dir(void) {
+// Lines are collected in memory and written with a single open/write/close by
+// log_flush(), which runs once before the chainload or on error.
+static char   g_logBuf[LOG_BUF_SIZE];
+static size_t g_logLen;
+
+static void log_flush(void) {
+    if (!g_logLen) return;
     mkdir(LOG_DIR, 0777);
+    FILE* f = fopen(LOG_PATH, "a");
+    if (f) { fwrite(g_logBuf, 1, g_logLen, f); fclose(f); }
+    g_logLen = 0;
 }
 
-static void log_msg(const char* s) {
-    ensure_log_dir();
-    FILE* f = fopen(LOG_PATH, "a");
-    if (f) { fprintf(f, "%s\n", s); fclose(f); }
+static void log_vappend(int level, const char* fmt, va_list ap) {
+    if (level > g_logLevel) return;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        size_t room = sizeof(g_logBuf) - g_logLen;
+        va_list cp;
+        va_copy(cp, ap);
+        int n = vsnprintf(g_logBuf + g_logLen, room, fmt, cp);
+        va_end(cp);
+        if (n < 0) return;
+        if ((size_t)n + 1 < room) {          // fits, including the newline
+            g_logLen += (size_t)n;
+            g_logBuf[g_logLen++] = '\n';
+            return;
+        }
+        if (g_logLen == 0) {                 // longer than the whole buffer
+            g_logLen = sizeof(g_logBuf) - 1;
+            g_logBuf[g_logLen++] = '\n';
+            return;
+        }
+        log_flush();                         // make room and retry once
+    }
 }
 
-static void log_printf(const char* fmt, ...) {
-    ensure_log_dir();
-    FILE* f = fopen(LOG_PATH, "a");
-    if (!f) return;
+static void log_printf(int level, const char* fmt, ...) {
     va_list ap; va_start(ap, fmt);
-    vfprintf(f, fmt, ap);
-    fprintf(f, "\n");
+    log_vappend(level, fmt, ap);
     va_end(ap);
-    fclose(f);
 }
 
-static void read_text_file(const char* path, char* out, size_t outsz) {
-    out[0] = 0;
-    FILE* f = fopen(path, "rb");
-    if (!f) return;
-    size_t n = fread(out, 1, outsz - 1, f);
-    fclose(f);
-    // trim trailing whitespace/newlines
-    while (n && (out[n-1] == '\n' || out[n-1] == '\r' || out[n-1] == ' ' || out[n-1] == '\t')) n--;
-    out[n] = 0;
+static void log_msg(int level, const char* s) {
+    log_printf(level, "%s", s);
 }
 
-// Placeholder: we’ll wire the hbloader handoff here next.
-static Result chainload_nro(const char* nroPath, const char* argvLine) {
-    (void)nroPath; (void)argvLine;
-    // Custom stub error (module 346, desc 1) just to show something non-zero
-    return MAKERESULT(346, 1);
+// Patched per title by the packer after linking.
+__attribute__((used, aligned(16)))
+static const LaunchEmbed g_launchEmbed = { .tag = LAUNCH_EMBED_TAG };
+
+// The compiler sees the all-zero initializer; launder the pointer so reads are
+// not constant-folded away.
+static const LaunchEmbed* launch_embed(void) {
+    const LaunchEmbed* e = &g_launchEmbed;
+    __asm__("" : "+r"(e));
+    return e;
 }
 
-int main(int argc, char* argv[]) {
-    (void)argc; (void)argv;
+// Bounds-check a descriptor once. Takes ownership of data (malloc'd).
+// Returns NULL on success, else a short description of the problem.
+static const char* launch_parse(Launch* l, u8* data, size_t size) {
+    l->data = data;
+    const LaunchHeader* h = (const LaunchHeader*)l->data;
+    if (size < sizeof(LaunchHeader) || memcmp(h->magic, LAUNCH_MAGIC, 4) != 0
+        || h->version == 0 || h->version > LAUNCH_VERSION
+        || h->header_size < LAUNCH_HEADER_V1_SIZE || h->total_size > size)
+        return "invalid or unsupported launch descriptor";
+    if ((u64)h->argv_offset + 4ull * h->argc > h->total_size
+        || (u64)h->fallback_offset + 4ull * h->fallback_count > h->total_size
+        || (u64)h->strtab_offset + h->strtab_size > h->total_size
+        || h->strtab_size == 0 || l->data[h->strtab_offset + h->strtab_size - 1] != 0)
+        return "launch descriptor layout out of bounds";
+    if (h->header_size >= sizeof(LaunchHeader) && h->core_count) {
+        if ((u64)h->core_offset + 4ull * h->core_count > h->total_size || h->core_arg >= h->argc)
+            return "launch descriptor layout out of bounds";
+        l->coreCount = h->core_count;
+    }
+    l->hdr = h;
+    return NULL;
+}
 
-    // Init services & filesystems
-    fsInitialize();         // FS service first
-    fsdevMountSdmc();       // enables stdio on sdmc:/
-    romfsInit();            // mount romfs:/
+// Descriptor embedded in our own .rodata (no RomFS needed).
+static const char* launch_from_embed(Launch* l) {
+    memset(l, 0, sizeof(*l));
+    const LaunchEmbed* e = launch_embed();
+    size_t size = e->size;
+    if (size < sizeof(LaunchHeader) || size > LAUNCH_EMBED_SIZE)
+        return "embedded launch descriptor has a bad size";
+    u8* data = malloc(size);
+    if (!data) return "out of memory";
+    memcpy(data, e->data, size);
+    return launch_parse(l, data, size);
+}
 
-    log_msg("SRP forwarder start");
+// Read romfs:/launch.bin with a single fread.
+static const char* launch_load(Launch* l, const char* path) {
+    memset(l, 0, sizeof(*l));
+    struct stat st;
+    if (stat(path, &st) != 0) return "launch descriptor missing";
+    if (st.st_size < (off_t)sizeof(LaunchHeader) || st.st_size > LAUNCH_MAX_SIZE)
+        return "launch descriptor has a bad size";
+
+    size_t size = (size_t)st.st_size;
+    u8* data = malloc(size);
+    if (!data) return "out of memory";
+    FILE* f = fopen(path, "rb");
+    size_t n = f ? fread(data, 1, size, f) : 0;
+    if (f) fclose(f);
+    if (n != size) {
+        free(data);
+        return "cannot read launch descriptor";
+    }
+    return launch_parse(l, data, size);
+}
 
-    // Read parameters from romfs
-    char nroPath[512];
-    char argvLine[768];
-    read_text_file(NRO_FILE, nroPath, sizeof(nroPath));
-    read_text_file(ARG_FILE, argvLine, sizeof(argvLine));
+static void launch_free(Launch* l) {
+    free(l->data);
+    memset(l, 0, sizeof(*l));
+}
 
-    log_printf("nextNroPath=%s", nroPath[0] ? nroPath : "(missing)");
-    log_printf("nextArgv=%s",    argvLine[0] ? argvLine : "(missing)");
+// Strings are NUL-terminated inside the string table (checked in launch_parse).
+static const char* launch_str(const Launch* l, u32 off) {
+    return off < l->hdr->strtab_size ? (const char*)l->data + l->hdr->strtab_offset + off : "";
+}
 
-    // Simple on-screen feedback
-    consoleInit(NULL);
-    printf("Switch ROM Packer Forwarder\n\n");
+static const char* launch_table_str(const Launch* l, u32 tableOffset, u32 i) {
+    u32 off;
+    memcpy(&off, l->data + tableOffset + 4 * i, sizeof(off));
+    return launch_str(l, off);
+}
 
-    if (!nroPath[0]) {
-        printf("Error: romfs:/nextNroPath missing\n");
-        log_msg("ERROR: nextNroPath missing");
-    } else {
-        printf("Target NRO:\n%s\n\n", nroPath);
-        Result rc = chainload_nro(nroPath, argvLine);
-        if (R_FAILED(rc)) {
-            printf("Launch not implemented yet (rc=0x%x)\n", rc);
-            log_printf("chainload_nro not implemented (rc=0x%x)", rc);
+// First of target + fallbacks that exists on the SD card, or NULL.
+static const char* launch_pick_target(const Launch* l) {
+    struct stat st;
+    const char* target = launch_str(l, l->hdr->target_off);
+    if (target[0] && stat(target, &st) == 0) return target;
+    for (u32 i = 0; i < l->hdr->fallback_count; i++) {
+        const char* alt = launch_table_str(l, l->hdr->fallback_offset, i);
+        if (alt[0] && stat(alt, &st) == 0) {
+            log_printf(LOG_INFO, "target missing, using fallback %s", alt);
+            return alt;
         }
     }
+    return NULL;
+}
+
+// Stat each core candidate once, in priority order; the first one installed is
+// substituted into argv. Returns false if the descriptor lists cores but none exist.
+static bool launch_pick_core(Launch* l) {
+    struct stat st;
+    for (u32 i = 0; i < l->coreCount; i++) {
+        const char* core = launch_table_str(l, l->hdr->core_offset, i);
+        if (core[0] && stat(core, &st) == 0) {
+            if (i) log_printf(LOG_INFO, "preferred core missing, using %s", core);
+            l->core = core;
+            return true;
+        }
+    }
+    return l->coreCount == 0;
+}
+
+static const char* launch_arg(const Launch* l, u32 i) {
+    if (l->core && i == l->hdr->core_arg) return l->core;
+    return launch_table_str(l, l->hdr->argv_offset, i);
+}
+
+// Hand off to nroPath via the homebrew loader's next-load mechanism. The loader
+// starts the target as soon as we return from main(). argv[0] must be the NRO
+// path itself; every argument is quoted so paths with spaces survive.
+static Result chainload_nro(const Launch* l, const char* nroPath) {
+    if (!envHasNextLoad())
+        return MAKERESULT(Module_Libnx, LibnxError_NotInitialized);
+
+    size_t len = strlen(nroPath) + 3;
+    for (u32 i = 0; i < l->hdr->argc; i++)
+        len += strlen(launch_arg(l, i)) + 3;
+
+    char* fullArgv = malloc(len + 1);
+    if (!fullArgv)
+        return MAKERESULT(Module_Libnx, LibnxError_OutOfMemory);
+    size_t pos = (size_t)snprintf(fullArgv, len + 1, "\"%s\"", nroPath);
+    for (u32 i = 0; i < l->hdr->argc; i++)
+        pos += (size_t)snprintf(fullArgv + pos, len + 1 - pos, " \"%s\"", launch_arg(l, i));
+
+    log_printf(LOG_INFO, "argv=%s", fullArgv);
+    Result rc = envSetNextLoad(nroPath, fullArgv);
+    free(fullArgv);
+    return rc;
+}
+
+// Only reached on failure: show what went wrong and wait for +.
+static void show_error(const char* nroPath, const char* what, Result rc) {
+    log_flush();
+    consoleInit(NULL);
+    printf("Switch ROM Packer Forwarder\n\n");
+    if (nroPath && nroPath[0]) printf("Target NRO:\n%s\n\n", nroPath);
+    if (rc) printf("Error: %s (rc=0x%x)\n", what, rc);
+    else    printf("Error: %s\n", what);
     printf("\nPress + to exit.\n");
 
     // Modern input API (pad*)
@@ -99,9 +258,91 @@ int main(int argc, char* argv[]) {
         consoleUpdate(NULL);
     }
     consoleExit(NULL);
+}
+
+// Log the stage timings, flush the log and (with TRACE=1 or LAUNCH_FLAG_TRACE)
+// append the record.
+static void finish_trace(BootTrace* trace, u32 status, bool writeRecord) {
+    char line[160];
+    trace->rec.status = status;
+    bootTraceFormat(trace, line, sizeof(line));
+    log_msg(status ? LOG_ERROR : LOG_INFO, line);
+    log_flush();
+    if (writeRecord) bootTraceWrite(trace);
+}
+
+int main(int argc, char* argv[]) {
+    (void)argc; (void)argv;
+
+    BootTrace trace;
+    bootTraceBegin(&trace, BOOTTRACE_FORWARDER);
+
+    // Init services & filesystems
+    fsInitialize();         // FS service first
+    bootTraceMark(&trace, FWD_STAGE_FS_INIT);
+    fsdevMountSdmc();       // enables stdio on sdmc:/
+    bootTraceMark(&trace, FWD_STAGE_SDMC_MOUNT);
+
+    // Patched NSOs carry the descriptor themselves; only older builds need RomFS.
+    Launch launch;
+    const char* err;
+    bool romfsMounted = false;
+    bool embedded = launch_embed()->size != 0;
+    if (embedded) {
+        err = launch_from_embed(&launch);
+    } else {
+        romfsMounted = R_SUCCEEDED(romfsInit());
+        bootTraceMark(&trace, FWD_STAGE_ROMFS_INIT);
+        err = launch_load(&launch, LAUNCH_PATH);
+    }
+    bootTraceMark(&trace, FWD_STAGE_READ_PARAMS);
+
+    bool writeTrace = SRP_TRACE;
+    if (!err) {
+        if (launch.hdr->flags & LAUNCH_FLAG_VERBOSE_LOG) g_logLevel = LOG_INFO;
+        if (launch.hdr->flags & LAUNCH_FLAG_TRACE)       writeTrace = true;
+    }
+    log_msg(LOG_INFO, "SRP forwarder start");
+
+    if (err) {
+        log_printf(LOG_ERROR, "ERROR: %s (%s)", err, embedded ? "embedded" : LAUNCH_PATH);
+        finish_trace(&trace, FWD_ERR_NO_PARAMS, writeTrace);
+        show_error(NULL, err, 0);
+    } else {
+        const char* target = launch_str(&launch, launch.hdr->target_off);
+        log_printf(LOG_INFO, "target=%s (%u args, %u fallbacks, %u cores)", target,
+                   launch.hdr->argc, launch.hdr->fallback_count, launch.coreCount);
+
+        const char* nroPath = launch_pick_target(&launch);
+        bool haveCore = nroPath && launch_pick_core(&launch);
+        bootTraceMark(&trace, FWD_STAGE_STAT_TARGET);
+        if (!nroPath) {
+            log_printf(LOG_ERROR, "ERROR: target NRO not found on SD: %s", target);
+            finish_trace(&trace, FWD_ERR_NO_TARGET, writeTrace);
+            show_error(target, "target NRO not found on SD card", 0);
+        } else if (!haveCore) {
+            const char* first = launch_table_str(&launch, launch.hdr->core_offset, 0);
+            log_printf(LOG_ERROR, "ERROR: none of %u cores installed (first: %s)", launch.coreCount, first);
+            finish_trace(&trace, FWD_ERR_NO_CORE, writeTrace);
+            show_error(nroPath, "no suitable core installed on SD card", 0);
+        } else {
+            Result rc = chainload_nro(&launch, nroPath);
+            bootTraceMark(&trace, FWD_STAGE_HANDOFF);
+            if (R_FAILED(rc)) {
+                log_printf(LOG_ERROR, "chainload_nro failed (rc=0x%x)", rc);
+                finish_trace(&trace, FWD_ERR_CHAINLOAD, writeTrace);
+                show_error(nroPath, envHasNextLoad() ? "homebrew loader rejected the target"
+                                                     : "no homebrew loader next-load support", rc);
+            } else {
+                log_msg(LOG_INFO, "chainload queued");
+                finish_trace(&trace, FWD_OK, writeTrace);
+            }
+        }
+    }
+    launch_free(&launch);
 
     // Cleanup
-    romfsExit();
+    if (romfsMounted) romfsExit();
     fsdevUnmountAll();
     fsExit();
     return 0;
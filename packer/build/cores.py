@@ -37,6 +37,8 @@ _CANONICAL: Dict[str, str] = {
     "sms": "Sega - Master System - Mark III",
     "master system": "Sega - Master System - Mark III",
     "game gear": "Sega - Game Gear",
+    "sega cd": "Sega - Mega-CD - Sega CD",
+    "mega cd": "Sega - Mega-CD - Sega CD",
     "32x": "Sega - 32X",
     "saturn": "Sega - Saturn",
     "dreamcast": "Sega - Dreamcast",
@@ -82,6 +84,13 @@ def canonical_platform(libretro_platform_or_alias: str) -> str:
 
 # ---------- Core map loading & resolution ----------
 
+# Where RetroArch's NRO may live, in the order the forwarder tries them (older
+# releases installed it directly under /switch/).
+RETROARCH_NRO_PATHS = [
+    "sdmc:/switch/retroarch/retroarch_switch.nro",
+    "sdmc:/switch/retroarch_switch.nro",
+]
+
 @dataclass
 class CoreMap:
     default_core_dir: str
@@ -144,14 +153,21 @@ def load_core_map(custom_path: Optional[Path]) -> CoreMap:
     # Fallback
     return _BUILTIN_COREMAP
 
+def resolve_core_candidates(platform_name: str, core_map: CoreMap) -> List[str]:
+    """
+    Returns every listed core for the (canonical) platform as absolute paths, in
+    priority order. The forwarder launches the first one present on the SD card.
+    """
+    canonical = canonical_platform(platform_name)
+    candidates = core_map.platforms.get(canonical) or core_map.platforms.get(platform_name) or []
+    core_dir = core_map.default_core_dir.rstrip("/")
+    return [f"{core_dir}/{c}" for c in candidates]
+
 def resolve_core_so(platform_name: str, core_map: CoreMap) -> Optional[str]:
     """
     Returns absolute core path like:
       sdmc:/switch/retroarch/cores/snes9x2010_libretro_libnx.so
     Picks the first listed core for the (canonical) platform. Does not check SD existence.
     """
-    canonical = canonical_platform(platform_name)
-    candidates = core_map.platforms.get(canonical) or core_map.platforms.get(platform_name)
-    if not candidates:
-        return None
-    return f'{core_map.default_core_dir.rstrip("/")}/{candidates[0]}'
+    candidates = resolve_core_candidates(platform_name, core_map)
+    return candidates[0] if candidates else None
@@ -0,0 +1,116 @@
+# packer/build/dedup.py
+from __future__ import annotations
+
+import re
+import zipfile
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Any, Callable, Dict, Hashable, List, Optional, Tuple
+
+from packer.discovery.systems import sniff_platform, sniff_stream
+from packer.io.archive import open_rom, rom_stat, split_member
+
+# Preference rules for the copy of a duplicated ROM that gets built, applied
+# in order until one decides:
+#   header   its platform is the one its header identifies (e.g. a DMG-only ROM
+#            found in both gb and gbc folders is kept as Game Boy)
+#   tagged   its file name carries No-Intro/Redump tags such as "(USA)" or "[!]"
+#   shallow  fewest folder levels below rom_root
+#   name     alphabetical file name
+DEDUP_RULES = ("header", "tagged", "shallow", "name")
+DEFAULT_DEDUP_PREFER = "header,tagged,shallow,name"
+
+_TAG = re.compile(r"\([^)]*\)|\[[^\]]*\]")
+
+Item = Dict[str, Any]        # the CLI's item dicts: platform, rom_path, title, ...
+
+
+@dataclass
+class DuplicateGroup:
+    canonical: Item
+    duplicates: List[Item] = field(default_factory=list)
+    payload_bytes: int = 0      # size of one copy
+
+    @property
+    def bytes_saved(self) -> int:
+        return self.payload_bytes * len(self.duplicates)
+
+
+def parse_rules(spec: str) -> List[str]:
+    """--dedup-prefer value -> rule list; raises ValueError on unknown rules."""
+    rules = [r.strip().lower() for r in spec.split(",") if r.strip()]
+    unknown = [r for r in rules if r not in DEDUP_RULES]
+    if unknown:
+        raise ValueError(f"unknown rule(s) {', '.join(unknown)} (choose from {', '.join(DEDUP_RULES)})")
+    return rules
+
+
+def find_duplicates(
+    items: List[Item],
+    key_of: Callable[[Item], Optional[Tuple[Hashable, int]]],
+    rules: List[str],
+    rom_root: Path,
+) -> Tuple[List[Item], List[DuplicateGroup]]:
+    """
+    Split items into the ones to build and groups of identical payloads.
+    key_of returns (content key, payload bytes), or None for items that
+    could not be hashed (always built). Items to build keep their order.
+    """
+    by_key: Dict[Hashable, List[Item]] = {}
+    sizes: Dict[Hashable, int] = {}
+    keys: List[Optional[Hashable]] = []
+    for item in items:
+        k = key_of(item)
+        keys.append(k[0] if k else None)
+        if k:
+            by_key.setdefault(k[0], []).append(item)
+            sizes[k[0]] = k[1]
+
+    groups: Dict[Hashable, DuplicateGroup] = {}
+    for k, members in by_key.items():
+        if len(members) > 1:
+            ranked = sorted(members, key=_preference(members, rules, Path(rom_root)))
+            groups[k] = DuplicateGroup(canonical=ranked[0], duplicates=ranked[1:], payload_bytes=sizes[k])
+
+    keep = [
+        item for item, k in zip(items, keys)
+        if k is None or k not in groups or groups[k].canonical is item
+    ]
+    return keep, list(groups.values())
+
+
+def _sniff(path: Path, platforms: set) -> Optional[str]:
+    """Header platform of a ROM; archive members (Foo.zip/Foo.gb) are read through the archive."""
+    if split_member(path) is None:
+        return sniff_platform(path, platforms)
+    try:
+        with open_rom(path) as f:
+            return sniff_stream(f, rom_stat(path).st_size, platforms)
+    except (OSError, zipfile.BadZipFile):
+        return None
+
+
+def _preference(members: List[Item], rules: List[str], rom_root: Path) -> Callable[[Item], tuple]:
+    platforms = {m["platform"] for m in members}
+    sniffed: Dict[int, Optional[str]] = {}
+
+    def _header(item: Item) -> int:
+        if len(platforms) < 2:
+            return 0
+        if id(item) not in sniffed:
+            sniffed[id(item)] = _sniff(item["rom_path"], platforms)
+        return 0 if sniffed[id(item)] == item["platform"] else 1
+
+    def _depth(p: Path) -> int:
+        try:
+            return len(p.relative_to(rom_root).parts)
+        except ValueError:
+            return len(p.parts)
+
+    scorers = {
+        "header": _header,
+        "tagged": lambda it: 0 if _TAG.search(it["rom_path"].stem) else 1,
+        "shallow": lambda it: _depth(it["rom_path"]),
+        "name": lambda it: it["rom_path"].name.lower(),
+    }
+    return lambda it: tuple(scorers[r](it) for r in rules) + (str(it["rom_path"]),)
@@ -0,0 +1,114 @@
+# packer/build/index.py
+from __future__ import annotations
+
+import json
+import os
+from collections import Counter
+from dataclasses import asdict, dataclass, field
+from pathlib import Path
+from typing import Dict, Iterable, List, Optional
+
+from packer.io.fsutil import atomic_write_text
+
+from .playlist import PlaylistEntry
+
+# Kept in the output dir: which outputs each ROM produced, so later runs
+# (and watch mode) can rebuild single titles and delete outputs that are stale.
+BUILD_INDEX_NAME = "build-index.json"
+BUILD_INDEX_VERSION = 1
+
+
+@dataclass
+class BuildRecord:
+    platform: str
+    title: str
+    size: int
+    mtime_ns: int
+    outputs: List[str] = field(default_factory=list)      # relative to the output dir
+    playlist: Optional[PlaylistEntry] = None
+
+    def is_current(self, st: os.stat_result) -> bool:
+        return self.size == st.st_size and self.mtime_ns == st.st_mtime_ns
+
+
+class BuildIndex:
+    """ROM path -> BuildRecord for everything currently in the output dir."""
+
+    def __init__(self, out_dir: Path, records: Optional[Dict[str, BuildRecord]] = None) -> None:
+        self.out_dir = Path(out_dir)
+        self.records: Dict[str, BuildRecord] = {}
+        # Two ROMs can map to the same output name; outputs are only deleted
+        # once no record claims them.
+        self._claims: Counter = Counter()
+        for rom, rec in (records or {}).items():
+            self._add(rom, rec)
+
+    @property
+    def path(self) -> Path:
+        return self.out_dir / BUILD_INDEX_NAME
+
+    @classmethod
+    def load(cls, out_dir: Path) -> "BuildIndex":
+        index = cls(out_dir)
+        try:
+            data = json.loads(index.path.read_text(encoding="utf-8"))
+        except FileNotFoundError:
+            return index
+        except (OSError, ValueError) as e:
+            print(f"[packer] Ignoring unreadable build index {index.path}: {e}")
+            return index
+        if not isinstance(data, dict) or data.get("version") != BUILD_INDEX_VERSION:
+            return index
+        for rom, rec in (data.get("roms") or {}).items():
+            try:
+                playlist = PlaylistEntry(**rec["playlist"]) if rec.get("playlist") else None
+                index._add(rom, BuildRecord(
+                    platform=rec["platform"],
+                    title=rec["title"],
+                    size=rec["size"],
+                    mtime_ns=rec["mtime_ns"],
+                    outputs=list(rec.get("outputs") or []),
+                    playlist=playlist,
+                ))
+            except (KeyError, TypeError):
+                continue
+        return index
+
+    def save(self) -> None:
+        roms = {rom: asdict(rec) for rom, rec in sorted(self.records.items())}
+        atomic_write_text(self.path, json.dumps({"version": BUILD_INDEX_VERSION, "roms": roms}, indent=1))
+
+    def playlist_entries(self, platforms: Optional[Iterable[str]] = None) -> List[PlaylistEntry]:
+        wanted = set(platforms) if platforms is not None else None
+        return [
+            rec.playlist for rec in self.records.values()
+            if rec.playlist is not None and (wanted is None or rec.platform in wanted)
+        ]
+
+    def replace(self, rom: str, record: BuildRecord) -> None:
+        """Record a (re)build of rom, deleting its previous outputs that were not produced again."""
+        old = self.records.pop(rom, None)
+        self._add(rom, record)
+        if old is not None:
+            self._release(old.outputs)
+
+    def drop(self, rom: str) -> None:
+        """Forget a ROM that is gone and delete its outputs."""
+        old = self.records.pop(rom, None)
+        if old is not None:
+            self._release(old.outputs)
+
+    def _add(self, rom: str, record: BuildRecord) -> None:
+        self.records[rom] = record
+        self._claims.update(record.outputs)
+
+    def _release(self, outputs: Iterable[str]) -> None:
+        for rel in outputs:
+            self._claims[rel] -= 1
+            if self._claims[rel] > 0:
+                continue
+            del self._claims[rel]
+            p = self.out_dir / rel
+            if p.is_file():
+                p.unlink()
+                print(f"[packer] Removed stale output {p}")
@@ -0,0 +1,87 @@
+# packer/build/inventory.py
+from __future__ import annotations
+
+import json
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Iterable, List, Optional, Set
+
+from .cores import RETROARCH_NRO_PATHS, CoreMap, resolve_core_candidates
+
+SD_PREFIX = "sdmc:/"
+CORE_SUFFIX = "_libretro_libnx.so"
+
+
+@dataclass
+class SDInventory:
+    """
+    What is actually installed on a target SD card, as sdmc:/ paths.
+
+    Built from a mounted SD root, or from a JSON listing exported from the console:
+      {"files": ["sdmc:/switch/retroarch/cores/snes9x_libretro_libnx.so",
+                 "sdmc:/switch/retroarch/retroarch_switch.nro", ...]}
+    ("cores" and "nros" lists are accepted as aliases for "files").
+    """
+    files: Set[str] = field(default_factory=set)
+    source: str = ""
+
+    def has(self, sd_path: str) -> bool:
+        # FAT32/exFAT on the Switch is case-insensitive.
+        return _norm(sd_path) in self.files
+
+    def first_present(self, sd_paths: Iterable[str]) -> Optional[str]:
+        return next((p for p in sd_paths if self.has(p)), None)
+
+
+def _norm(sd_path: str) -> str:
+    p = sd_path.strip().replace("\\", "/")
+    if p.lower().startswith(SD_PREFIX):
+        p = p[len(SD_PREFIX):]
+    return p.lstrip("/").casefold()
+
+
+def _sd_to_local(sd_root: Path, sd_path: str) -> Path:
+    rel = sd_path[len(SD_PREFIX):] if sd_path.lower().startswith(SD_PREFIX) else sd_path
+    return sd_root / rel.lstrip("/")
+
+
+def scan_sd_inventory(sd_root: Path, core_map: CoreMap) -> SDInventory:
+    """List cores under the core map's core dir and the RetroArch NRO locations."""
+    inv = SDInventory(source=str(sd_root))
+    core_dir = _sd_to_local(sd_root, core_map.default_core_dir)
+    if core_dir.is_dir():
+        base = core_map.default_core_dir.rstrip("/")
+        for p in core_dir.iterdir():
+            if p.name.endswith(CORE_SUFFIX) and p.is_file():
+                inv.files.add(_norm(f"{base}/{p.name}"))
+    for nro in RETROARCH_NRO_PATHS:
+        if _sd_to_local(sd_root, nro).is_file():
+            inv.files.add(_norm(nro))
+    return inv
+
+
+def load_sd_inventory(path: Path, core_map: CoreMap) -> SDInventory:
+    """--sd-inventory: a mounted SD card root, or a JSON listing."""
+    path = Path(path)
+    if path.is_dir():
+        return scan_sd_inventory(path, core_map)
+    if not path.is_file():
+        raise SystemExit(f"[packer] --sd-inventory not found: {path}")
+    try:
+        data = json.loads(path.read_text(encoding="utf-8"))
+    except (OSError, ValueError) as e:
+        raise SystemExit(f"[packer] --sd-inventory {path}: {e}")
+    listed: List[str] = []
+    if isinstance(data, list):
+        listed = data
+    elif isinstance(data, dict):
+        for key in ("files", "cores", "nros"):
+            listed += data.get(key) or []
+    if not all(isinstance(x, str) for x in listed):
+        raise SystemExit(f"[packer] --sd-inventory {path}: expected a list of sdmc:/ paths.")
+    return SDInventory(files={_norm(x) for x in listed}, source=str(path))
+
+
+def installed_core_candidates(platform: str, core_map: CoreMap, inventory: SDInventory) -> List[str]:
+    """resolve_core_candidates, restricted to cores present in the inventory (priority kept)."""
+    return [c for c in resolve_core_candidates(platform, core_map) if inventory.has(c)]
@@ -0,0 +1,134 @@
+# packer/build/launch.py
+from __future__ import annotations
+
+import struct
+from dataclasses import dataclass, field
+from typing import List
+
+from packer.io.filelist import _StringTable
+
+# ---------- Forwarder launch descriptor (romfs:/launch.bin) ----------
+#
+# Little-endian, read by the forwarder in a single fread. Layout:
+#
+#   header  (LAUNCH_HEADER_SIZE bytes)
+#     char[4] magic "SRPL"
+#     u16     version
+#     u16     header_size
+#     u32     total_size       size of the whole descriptor
+#     u32     flags            LAUNCH_FLAG_*
+#     u32     target_off       NRO to chainload (strtab offset)
+#     u32     argc             arguments after argv[0] (argv[0] is the NRO itself)
+#     u32     argv_offset      u32[argc] strtab offsets
+#     u32     fallback_count   alternative NROs tried in order if target is missing
+#     u32     fallback_offset  u32[fallback_count] strtab offsets
+#     u32     strtab_offset
+#     u32     strtab_size
+#     u32     core_count       (v2+) ordered core candidates
+#     u32     core_offset      (v2+) u32[core_count] strtab offsets
+#     u32     core_arg         (v2+) argv index the first installed candidate replaces
+#
+#   argv, fallbacks, cores, then strtab (NUL-terminated UTF-8 strings)
+#
+# Keep in sync with forwarder/include/launch.h.
+
+LAUNCH_NAME = "launch.bin"
+LAUNCH_MAGIC = b"SRPL"
+LAUNCH_VERSION = 2
+
+LAUNCH_FLAG_VERBOSE_LOG = 0x0001   # log at info level regardless of the build's LOG_LEVEL
+LAUNCH_FLAG_TRACE = 0x0002         # append a boot trace record (as with TRACE=1)
+
+_HEADER_V1 = struct.Struct("<4sHHIIIIIIIII")
+_HEADER = struct.Struct("<4sHHIIIIIIIIIIII")
+
+LAUNCH_HEADER_SIZE = _HEADER.size
+
+
+@dataclass
+class LaunchDescriptor:
+    target: str                                         # e.g. sdmc:/switch/retroarch/retroarch_switch.nro
+    argv: List[str] = field(default_factory=list)       # argv[1:], one element per argument
+    fallbacks: List[str] = field(default_factory=list)  # alternative targets, in priority order
+    flags: int = 0
+    cores: List[str] = field(default_factory=list)      # core candidates, in priority order
+    core_arg: int = 0                                   # argv index replaced by the chosen core
+
+
+def encode_launch(desc: LaunchDescriptor) -> bytes:
+    if desc.cores and not 0 <= desc.core_arg < len(desc.argv):
+        raise ValueError(f"core_arg {desc.core_arg} is outside argv ({len(desc.argv)} entries)")
+    strings = [desc.target, *desc.argv, *desc.fallbacks, *desc.cores]
+    for s in strings:
+        if "\0" in s:
+            raise ValueError(f"NUL byte in launch descriptor string {s!r}")
+        if '"' in s:
+            # hbloader splits argv on spaces and groups with double quotes only.
+            raise ValueError(f"double quote in launch descriptor string {s!r}")
+
+    strtab = _StringTable()
+    target_off = strtab.add(desc.target)
+    argv_offs = [strtab.add(a) for a in desc.argv]
+    fallback_offs = [strtab.add(f) for f in desc.fallbacks]
+    core_offs = [strtab.add(c) for c in desc.cores]
+    strtab_bytes = strtab.bytes()
+
+    argv_offset = LAUNCH_HEADER_SIZE
+    fallback_offset = argv_offset + 4 * len(argv_offs)
+    core_offset = fallback_offset + 4 * len(fallback_offs)
+    strtab_offset = core_offset + 4 * len(core_offs)
+    total = strtab_offset + len(strtab_bytes)
+
+    header = _HEADER.pack(
+        LAUNCH_MAGIC,
+        LAUNCH_VERSION,
+        LAUNCH_HEADER_SIZE,
+        total,
+        desc.flags,
+        target_off,
+        len(argv_offs),
+        argv_offset,
+        len(fallback_offs),
+        fallback_offset,
+        strtab_offset,
+        len(strtab_bytes),
+        len(core_offs),
+        core_offset,
+        desc.core_arg if core_offs else 0,
+    )
+    offsets = [*argv_offs, *fallback_offs, *core_offs]
+    tables = struct.pack(f"<{len(offsets)}I", *offsets)
+    return header + tables + strtab_bytes
+
+
+def decode_launch(data: bytes) -> LaunchDescriptor:
+    """Inverse of encode_launch (used for inspection and tests)."""
+    if len(data) < _HEADER_V1.size:
+        raise ValueError("launch descriptor too short")
+    (magic, version, header_size, total, flags, target_off, argc, argv_offset,
+     fallback_count, fallback_offset, strtab_offset, strtab_size) = _HEADER_V1.unpack_from(data, 0)
+    if magic != LAUNCH_MAGIC:
+        raise ValueError(f"bad launch descriptor magic {magic!r}")
+    if version > LAUNCH_VERSION:
+        raise ValueError(f"unsupported launch descriptor version {version}")
+    if total > len(data) or strtab_offset + strtab_size > total:
+        raise ValueError("launch descriptor layout out of bounds")
+
+    core_count, core_offset, core_arg = 0, 0, 0
+    if version >= 2 and header_size >= _HEADER.size:
+        core_count, core_offset, core_arg = struct.unpack_from("<III", data, _HEADER_V1.size)
+
+    strtab = data[strtab_offset:strtab_offset + strtab_size]
+
+    def _str(off: int) -> str:
+        end = strtab.index(b"\0", off)
+        return strtab[off:end].decode("utf-8")
+
+    return LaunchDescriptor(
+        target=_str(target_off),
+        argv=[_str(o) for o in struct.unpack_from(f"<{argc}I", data, argv_offset)],
+        fallbacks=[_str(o) for o in struct.unpack_from(f"<{fallback_count}I", data, fallback_offset)],
+        flags=flags,
+        cores=[_str(o) for o in struct.unpack_from(f"<{core_count}I", data, core_offset)],
+        core_arg=core_arg,
+    )
@@ -9,6 +9,7 @@ from pathlib import Path
 from typing import Optional, Tuple
 
 from PIL import Image, ImageDraw, ImageFont  # Pillow
+from packer.io.archive import copy_rom
 from packer.io.fsutil import clean_dir
 
 
@@ -153,6 +154,7 @@ def build_nro_for_rom(
     author: str = "Switch Rom Packer",
     version: str = "1.0.0",
     make_clean: bool = True,
+    subdir: str = "",
 ) -> Path:
     stub_dir = Path(stub_dir)
     out_dir = Path(out_dir)
@@ -169,7 +171,7 @@ def build_nro_for_rom(
 
     dest_rom = romfs_dir / rom_path.name
     if not dest_rom.exists():
-        dest_rom.write_bytes(rom_path.read_bytes())
+        copy_rom(rom_path, dest_rom)
 
     # 3) Resolve APP_* env (icon AFTER clean so it survives).
     env = os.environ.copy()
@@ -190,7 +192,8 @@ def build_nro_for_rom(
     # 5) Move resulting NRO
     nro_dir = out_dir / "nro"
     nro_dir.mkdir(parents=True, exist_ok=True)
-    safe_title = _sanitize_title_for_filename(hb_title)
+    # hbmenu only lists one folder level, so a ROM's subfolder goes into the name
+    safe_title = _sanitize_title_for_filename(f"{hb_title} ({subdir.replace('/', ' - ')})" if subdir else hb_title)
     nro_out = nro_dir / f"{safe_title}.nro"
 
     built = stub_dir / "stub.nro"
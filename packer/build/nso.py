@@ -0,0 +1,210 @@
+# packer/build/nso.py
+from __future__ import annotations
+
+import hashlib
+import struct
+from pathlib import Path
+from typing import Optional
+
+# ---------- Per-title launch descriptor embedded in the forwarder NSO ----------
+#
+# The forwarder reserves a LaunchEmbed block in .rodata (forwarder/include/launch.h):
+#
+#   char[16] tag   LAUNCH_EMBED_TAG, NUL padded; found by scanning the ro segment
+#   u32      size  descriptor length, 0 = not patched (forwarder reads romfs:/launch.bin)
+#   u32[3]   reserved
+#   u8[LAUNCH_EMBED_SIZE] data
+#
+# Patching a copy of exefs/main lets an NSP ship without a RomFS section.
+
+LAUNCH_EMBED_TAG = b"SRP-LAUNCH-SLOT\0"
+LAUNCH_EMBED_SIZE = 4096
+_EMBED_HEAD = struct.Struct("<16sI12x")
+
+# ---------- NSO0 layout ----------
+NSO_MAGIC = b"NSO0"
+_NSO_HEADER_SIZE = 0x100
+_FLAGS_OFF = 0x0C
+_SEG_HDR_OFF = (0x10, 0x20, 0x30)         # u32 file_off, u32 mem_off, u32 size (+ u32 extra)
+_SEG_FILE_SIZE_OFF = (0x60, 0x64, 0x68)   # compressed size in file
+_SEG_HASH_OFF = (0xA0, 0xC0, 0xE0)        # SHA-256 of the decompressed segment
+_RO = 1
+
+
+def lz4_block_decompress(src: bytes, out_size: int) -> bytes:
+    """Decode one raw LZ4 block (no frame header), as used by NSO segments."""
+    dst = bytearray()
+    i, n = 0, len(src)
+    while i < n:
+        token = src[i]
+        i += 1
+        lit = token >> 4
+        if lit == 15:
+            while True:
+                b = src[i]
+                i += 1
+                lit += b
+                if b != 255:
+                    break
+        dst += src[i:i + lit]
+        i += lit
+        if i >= n:
+            break
+        off = src[i] | (src[i + 1] << 8)
+        i += 2
+        if off == 0 or off > len(dst):
+            raise ValueError("corrupt LZ4 block (bad match offset)")
+        ml = token & 15
+        if ml == 15:
+            while True:
+                b = src[i]
+                i += 1
+                ml += b
+                if b != 255:
+                    break
+        ml += 4
+        start = len(dst) - off
+        if off >= ml:
+            dst += dst[start:start + ml]
+        else:
+            for k in range(ml):                 # overlapping copy (run-length style)
+                dst.append(dst[start + k])
+    if len(dst) != out_size:
+        raise ValueError(f"LZ4 block decoded to {len(dst)} bytes, expected {out_size}")
+    return bytes(dst)
+
+
+def _lz4_len(out: bytearray, v: int) -> None:
+    v -= 15
+    while v >= 255:
+        out.append(255)
+        v -= 255
+    out.append(v)
+
+
+def lz4_block_compress(src: bytes) -> bytes:
+    """Greedy single-probe LZ4 block encoder; good enough for a small forwarder."""
+    try:
+        import lz4.block  # type: ignore
+        return lz4.block.compress(src, store_size=False)
+    except ImportError:
+        pass
+
+    n = len(src)
+    out = bytearray()
+    table: dict[bytes, int] = {}
+    anchor = i = 0
+    limit = n - 12                              # last match must start 12 bytes before the end
+    while i < limit:
+        key = src[i:i + 4]
+        cand = table.get(key)
+        table[key] = i
+        if cand is None or i - cand > 0xFFFF:
+            i += 1
+            continue
+        ml = 4
+        max_ml = n - 5 - i                      # last 5 bytes are always literals
+        while ml < max_ml and src[cand + ml] == src[i + ml]:
+            ml += 1
+        lit = i - anchor
+        out.append((min(lit, 15) << 4) | min(ml - 4, 15))
+        if lit >= 15:
+            _lz4_len(out, lit)
+        out += src[anchor:i]
+        out += struct.pack("<H", i - cand)
+        if ml - 4 >= 15:
+            _lz4_len(out, ml - 4)
+        i += ml
+        anchor = i
+    lit = n - anchor
+    out.append(min(lit, 15) << 4)
+    if lit >= 15:
+        _lz4_len(out, lit)
+    out += src[anchor:]
+    return bytes(out)
+
+
+def _segment(nso: bytes, seg: int) -> tuple[bytes, bool]:
+    """Return (decompressed bytes, was_compressed) for segment 0=text, 1=ro, 2=data."""
+    file_off, _mem_off, size = struct.unpack_from("<III", nso, _SEG_HDR_OFF[seg])
+    file_size = struct.unpack_from("<I", nso, _SEG_FILE_SIZE_OFF[seg])[0]
+    flags = struct.unpack_from("<I", nso, _FLAGS_OFF)[0]
+    raw = nso[file_off:file_off + file_size]
+    if len(raw) != file_size:
+        raise ValueError("NSO segment extends past end of file")
+    if flags & (1 << seg):
+        return lz4_block_decompress(raw, size), True
+    return raw, False
+
+
+def patch_nso_launch(nso: bytes, descriptor: bytes) -> bytes:
+    """
+    Return a copy of an NSO with `descriptor` written into its LaunchEmbed block.
+    The ro segment is decompressed, patched, rehashed and recompressed; text and
+    data keep their original bytes. Raises ValueError if the NSO has no (unique)
+    slot or the descriptor does not fit.
+    """
+    if nso[:4] != NSO_MAGIC or len(nso) < _NSO_HEADER_SIZE:
+        raise ValueError("not an NSO0 file")
+    if len(descriptor) > LAUNCH_EMBED_SIZE:
+        raise ValueError(f"launch descriptor is {len(descriptor)} bytes, slot holds {LAUNCH_EMBED_SIZE}")
+
+    ro, was_compressed = _segment(nso, _RO)
+    pos = ro.find(LAUNCH_EMBED_TAG)
+    if pos < 0:
+        raise ValueError("forwarder NSO has no launch descriptor slot")
+    if ro.find(LAUNCH_EMBED_TAG, pos + 1) >= 0:
+        raise ValueError("forwarder NSO has more than one launch descriptor slot")
+    data_off = pos + _EMBED_HEAD.size
+    if data_off + LAUNCH_EMBED_SIZE > len(ro):
+        raise ValueError("launch descriptor slot truncated")
+
+    patched = bytearray(ro)
+    patched[pos:data_off] = _EMBED_HEAD.pack(LAUNCH_EMBED_TAG, len(descriptor))
+    patched[data_off:data_off + LAUNCH_EMBED_SIZE] = descriptor.ljust(LAUNCH_EMBED_SIZE, b"\0")
+    patched = bytes(patched)
+    new_ro = lz4_block_compress(patched) if was_compressed else patched
+
+    # Re-lay out the file: header (+ module name) unchanged, then text, ro, data.
+    header = bytearray(nso[:_NSO_HEADER_SIZE])
+    seg_offsets = [struct.unpack_from("<I", nso, _SEG_HDR_OFF[s])[0] for s in range(3)]
+    prefix_end = min(seg_offsets)
+    out = bytearray(nso[:prefix_end])
+    for seg in range(3):
+        file_off = seg_offsets[seg]
+        file_size = struct.unpack_from("<I", nso, _SEG_FILE_SIZE_OFF[seg])[0]
+        body = new_ro if seg == _RO else nso[file_off:file_off + file_size]
+        struct.pack_into("<I", header, _SEG_HDR_OFF[seg], len(out))
+        struct.pack_into("<I", header, _SEG_FILE_SIZE_OFF[seg], len(body))
+        out += body
+    header[_SEG_HASH_OFF[_RO]:_SEG_HASH_OFF[_RO] + 32] = hashlib.sha256(patched).digest()
+    out[:_NSO_HEADER_SIZE] = header
+    return bytes(out)
+
+
+def read_nso_launch(nso: bytes) -> Optional[bytes]:
+    """Descriptor stored in an NSO's slot, or None if unpatched (inspection and tests)."""
+    ro, _ = _segment(nso, _RO)
+    pos = ro.find(LAUNCH_EMBED_TAG)
+    if pos < 0:
+        raise ValueError("forwarder NSO has no launch descriptor slot")
+    _tag, size = _EMBED_HEAD.unpack_from(ro, pos)
+    if size == 0:
+        return None
+    start = pos + _EMBED_HEAD.size
+    return ro[start:start + size]
+
+
+def embed_launch_in_nso(nso_path: Path, descriptor: bytes) -> bool:
+    """
+    Patch exefs/main in place. Returns False (leaving the file untouched) if the
+    NSO predates the slot or the descriptor is too large, so callers can fall
+    back to shipping romfs:/launch.bin.
+    """
+    try:
+        patched = patch_nso_launch(Path(nso_path).read_bytes(), descriptor)
+    except ValueError as e:
+        print(f"[packer] Not embedding launch descriptor in {nso_path.name}: {e}")
+        return False
+    Path(nso_path).write_bytes(patched)
+    return True
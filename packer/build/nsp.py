@@ -9,9 +9,12 @@ import subprocess
 import sys
 from dataclasses import dataclass
 from pathlib import Path
-from typing import Optional, Tuple
+from typing import Optional
 
-from .cores import load_core_map, resolve_core_so, canonical_platform
+from .cores import RETROARCH_NRO_PATHS, load_core_map, resolve_core_candidates, canonical_platform
+from .inventory import SDInventory, installed_core_candidates
+from .launch import LAUNCH_NAME, LaunchDescriptor, encode_launch
+from .nso import embed_launch_in_nso
 
 
 @dataclass
@@ -26,6 +29,12 @@ class NSPOptions:
     forwarder_mode: str  # "retroarch" | "nro"
     core_map_path: Optional[Path]
     titleid_base: Optional[str]  # 16-hex prefix/salt (optional)
+    sd_inventory: Optional[SDInventory] = None  # restrict cores/NRO to what is installed
+    rom_name: Optional[str] = None  # path below /roms/<platform>/ (default: rom_path.name)
+
+    @property
+    def sd_name(self) -> str:
+        return self.rom_name or self.rom_path.name
 
 
 # ---------- Paths ----------
@@ -47,6 +56,8 @@ def build_nsp_forwarder(
     forwarder_mode: str,
     core_map_path: Optional[Path],
     titleid_base: Optional[str],
+    sd_inventory: Optional[SDInventory] = None,
+    rom_name: Optional[str] = None,
 ) -> Path:
     """
     Create a minimal forwarder NSP using hacBrewPack.
@@ -54,9 +65,8 @@ def build_nsp_forwarder(
     work/
       control/control.nacp            (binary, generated via nacptool)
       logo/icon_AmericanEnglish.dat   (copied from icon_path)
-      exefs/main + exefs/main.npdm    (from stub/vendor/exefs; kept fresh by `forwarder install`)
-      romfs/nextNroPath               (forwarder target)
-      romfs/nextArgv                  (forwarder argv)
+      exefs/main + exefs/main.npdm    (from stub/vendor/exefs; main is patched with the launch descriptor)
+      romfs/launch.bin                (only if the descriptor could not be embedded in exefs/main)
       config.json                     (metadata for reference)
     """
     opts = NSPOptions(
@@ -70,6 +80,8 @@ def build_nsp_forwarder(
         forwarder_mode=forwarder_mode,
         core_map_path=core_map_path,
         titleid_base=titleid_base,
+        sd_inventory=sd_inventory,
+        rom_name=rom_name,
     )
 
     out_dir.mkdir(parents=True, exist_ok=True)
@@ -78,7 +90,7 @@ def build_nsp_forwarder(
     _ensure_vendor_exefs()
 
     # 1) Deterministic TitleID
-    title_id = _compute_title_id(opts.platform, opts.rom_path, opts.titleid_base)
+    title_id = _compute_title_id(opts.platform, opts.sd_name, opts.titleid_base)
 
     # 2) Stage working dir
     work = out_dir / f".work_{title_id}"
@@ -87,7 +99,6 @@ def build_nsp_forwarder(
     (work / "control").mkdir(parents=True, exist_ok=True)
     (work / "logo").mkdir(parents=True, exist_ok=True)
     (work / "exefs").mkdir(parents=True, exist_ok=True)
-    (work / "romfs").mkdir(parents=True, exist_ok=True)
 
     # 3) ExeFS (forwarder) -> stage from vendor
     _stage_vendor_exefs(exefs_dst=work / "exefs")
@@ -113,9 +124,11 @@ def build_nsp_forwarder(
     # 6) Icon
     _copy_icon(opts.icon_path, work / "logo" / "icon_AmericanEnglish.dat")
 
-    # 7) Forwarder romfs
-    next_nro, next_argv = _resolve_forwarder_targets(opts)
-    _write_forwarder_romfs(work / "romfs", next_nro, next_argv)
+    # 7) Launch descriptor: embedded in exefs/main, RomFS only as a fallback
+    launch = _encode_forwarder_launch(_resolve_forwarder_targets(opts))
+    use_romfs = not embed_launch_in_nso(work / "exefs" / "main", launch)
+    if use_romfs:
+        _write_forwarder_romfs(work / "romfs", launch)
 
     # 8) hacBrewPack
     hbp = _resolve_hacbrewpack_exe()
@@ -138,11 +151,11 @@ def build_nsp_forwarder(
         str(hbp),
         "-k", str(opts.keys_path),
         "--exefsdir", str(work / "exefs"),
-        "--romfsdir", str(work / "romfs"),
         "--controldir", str(work / "control"),
         "--logodir", str(work / "logo"),
         "--nspdir", str(opts.out_dir),  # dir, not file
     ]
+    cmd += ["--romfsdir", str(work / "romfs")] if use_romfs else ["--noromfs"]
     print(f"[packer] Running: {' '.join(_shell_quote(a) for a in cmd)}")
     try:
         subprocess.run(cmd, check=True)
@@ -207,8 +220,10 @@ def _stage_vendor_exefs(exefs_dst: Path) -> None:
         shutil.copy2(src, exefs_dst / name)
 
 
-def _compute_title_id(platform: str, rom_path: Path, titleid_base: Optional[str]) -> str:
-    h = hashlib.sha1(f"{platform}|{rom_path.name}".encode("utf-8")).hexdigest()
+def _compute_title_id(platform: str, sd_name: str, titleid_base: Optional[str]) -> str:
+    # Seeded by the SD path below /roms/<platform>/, which is the bare file
+    # name for ROMs directly in the platform folder (their IDs never change)
+    h = hashlib.sha1(f"{platform}|{sd_name}".encode("utf-8")).hexdigest()
     if titleid_base:
         base = "".join(c for c in titleid_base.lower() if c in "0123456789abcdef")
         base = base[:16] if len(base) >= 16 else base.zfill(16)
@@ -278,31 +293,60 @@ def _copy_icon(src_icon: Path, dest_icon: Path) -> None:
     shutil.copy2(src_icon, dest_icon)
 
 
-def _resolve_forwarder_targets(opts: NSPOptions) -> Tuple[str, str]:
-    rom_sd = f"sdmc:/roms/{opts.platform}/{opts.rom_path.name}"
+def _retroarch_nro_order(inventory: Optional[SDInventory]) -> list[str]:
+    """RetroArch NRO locations, with the one present on the SD card (if known) first."""
+    paths = list(RETROARCH_NRO_PATHS)
+    present = inventory.first_present(paths) if inventory else None
+    if present:
+        paths.remove(present)
+        paths.insert(0, present)
+    return paths
+
+
+def _resolve_forwarder_targets(opts: NSPOptions) -> LaunchDescriptor:
+    # For disc sets rom_path is the sheet (.cue/.gdi/.m3u); the core loads its tracks from there.
+    rom_sd = f"sdmc:/roms/{opts.platform}/{opts.sd_name}"
+    nro_target, *nro_fallbacks = _retroarch_nro_order(opts.sd_inventory)
     if opts.forwarder_mode == "retroarch":
         core_map = load_core_map(opts.core_map_path)
-        core_path = resolve_core_so(opts.platform, core_map)
-        if not core_path:
+        if opts.sd_inventory is not None:
+            cores = installed_core_candidates(opts.platform, core_map, opts.sd_inventory)
+        else:
+            cores = resolve_core_candidates(opts.platform, core_map)
+        if not cores:
             canon = canonical_platform(opts.platform)
+            where = f" installed per {opts.sd_inventory.source}" if opts.sd_inventory is not None else ""
             raise SystemExit(
-                "[packer] No core mapping for platform: "
+                f"[packer] No core{where} for platform: "
                 f"{opts.platform!r} (canonical: {canon!r}). "
                 "Add it to packer/data/cores.yml or pass --core-map."
             )
-        retroarch_nro = "sdmc:/switch/retroarch/retroarch_switch.nro"
-        return retroarch_nro, f'-L "{core_path}" "{rom_sd}"'
+        # argv[1] holds the preferred core; the forwarder swaps in the first
+        # candidate that is actually installed.
+        return LaunchDescriptor(
+            target=nro_target,
+            argv=["-L", cores[0], rom_sd],
+            fallbacks=nro_fallbacks,
+            cores=cores,
+            core_arg=1,
+        )
     elif opts.forwarder_mode == "nro":
         # Generic jump to hbmenu-compatible NRO (default RetroArch frontend)
-        return "sdmc:/switch/retroarch/retroarch_switch.nro", f'"{rom_sd}"'
+        return LaunchDescriptor(target=nro_target, argv=[rom_sd], fallbacks=nro_fallbacks)
     else:
         raise SystemExit(f"[packer] Unknown forwarder mode: {opts.forwarder_mode}")
 
 
-def _write_forwarder_romfs(romfs_dir: Path, next_nro_path: str, next_argv: str) -> None:
+def _encode_forwarder_launch(launch: LaunchDescriptor) -> bytes:
+    try:
+        return encode_launch(launch)
+    except ValueError as e:
+        raise SystemExit(f"[packer] Cannot encode forwarder launch descriptor: {e}")
+
+
+def _write_forwarder_romfs(romfs_dir: Path, launch: bytes) -> None:
     romfs_dir.mkdir(parents=True, exist_ok=True)
-    (romfs_dir / "nextNroPath").write_text(next_nro_path, encoding="utf-8")
-    (romfs_dir / "nextArgv").write_text(next_argv, encoding="utf-8")
+    (romfs_dir / LAUNCH_NAME).write_bytes(launch)
 
 
 def _resolve_hacbrewpack_exe() -> Optional[Path]:
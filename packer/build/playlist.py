@@ -0,0 +1,87 @@
+# packer/build/playlist.py
+from __future__ import annotations
+
+import json
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Dict, Iterable, List, Optional
+
+from packer.io.fsutil import atomic_write_text
+
+# RetroArch JSON playlist format (1.7.6+). Paths are on-console absolute paths
+# without the sdmc: prefix, which is how RetroArch on Switch stores them.
+LPL_VERSION = "1.5"
+PLAYLIST_DIR_NAME = "playlists"
+
+# Playlist-level thumbnail_match_mode: match thumbnails on the content file
+# name (No-Intro style, like libretro-thumbnails) instead of the label, so
+# labels can stay human-readable. A playlist whose entries all matched a DAT
+# is labelled with the DAT names and matches on those instead, so renamed
+# ROMs find their thumbnails too.
+THUMBNAIL_MATCH_LABEL = 0
+THUMBNAIL_MATCH_FILENAME = 1
+
+
+@dataclass
+class PlaylistEntry:
+    platform: str
+    dest: str                      # on-SD path, e.g. /roms/<platform>/<file>
+    label: str
+    crc32: Optional[int] = None
+    core_path: Optional[str] = None
+    thumbnail: Optional[str] = None  # libretro-thumbnails name from a DAT match (label is the DAT name)
+
+
+def sd_path(path: str) -> str:
+    """sdmc:/x -> /x (RetroArch on Switch uses plain absolute paths)."""
+    return "/" + path[len("sdmc:/"):] if path.startswith("sdmc:/") else path
+
+
+def core_display_name(core_path: str) -> str:
+    name = core_path.rsplit("/", 1)[-1]
+    for suffix in ("_libretro_libnx.so", "_libretro.so"):
+        if name.endswith(suffix):
+            return name[: -len(suffix)]
+    return name
+
+
+def build_playlist(platform: str, entries: Iterable[PlaylistEntry], with_crc: bool = True) -> dict:
+    entries = list(entries)
+    # RetroArch picks one match mode per playlist: label matching only when no
+    # entry would lose the file-name match it has otherwise
+    by_label = bool(entries) and all(e.thumbnail for e in entries)
+    items: List[dict] = []
+    for e in sorted(entries, key=lambda e: e.label.casefold()):
+        core = sd_path(e.core_path) if e.core_path else "DETECT"
+        items.append({
+            "path": sd_path(e.dest),
+            "label": e.label,
+            "core_path": core,
+            "core_name": core_display_name(core) if e.core_path else "DETECT",
+            "crc32": f"{e.crc32 & 0xFFFFFFFF:08X}|crc" if with_crc and e.crc32 is not None else "DETECT",
+            "db_name": f"{platform}.lpl",
+        })
+    return {
+        "version": LPL_VERSION,
+        "default_core_path": "",
+        "default_core_name": "",
+        "label_display_mode": 0,
+        "right_thumbnail_mode": 0,
+        "left_thumbnail_mode": 0,
+        "thumbnail_match_mode": THUMBNAIL_MATCH_LABEL if by_label else THUMBNAIL_MATCH_FILENAME,
+        "sort_mode": 0,
+        "items": items,
+    }
+
+
+def write_playlists(out_dir: Path, entries: Iterable[PlaylistEntry], with_crc: bool = True) -> List[Path]:
+    """Write <out_dir>/<platform>.lpl for every platform with entries."""
+    by_platform: Dict[str, List[PlaylistEntry]] = {}
+    for e in entries:
+        by_platform.setdefault(e.platform, []).append(e)
+    written: List[Path] = []
+    for platform, items in sorted(by_platform.items()):
+        path = Path(out_dir) / f"{platform}.lpl"
+        atomic_write_text(path, json.dumps(build_playlist(platform, items, with_crc), indent=2, ensure_ascii=False) + "\n")
+        written.append(path)
+    return written
@@ -1,18 +1,52 @@
 from __future__ import annotations
 
 import argparse
+import posixpath
 import shutil
+import sys
+import time
 from pathlib import Path
-from typing import Any, Dict, List, Tuple, Optional
-
-from packer.discovery.detect import discover_roms
-from packer.metadata.titles import parse_rom_title
-from packer.icons.match import find_icon_with_alts
-from packer.io.filelist import write_filelist
+from typing import Any, Dict, Iterable, Iterator, List, Tuple, Optional
+
+from packer.discovery.cache import DiscoveryCache
+from packer.discovery.detect import DEFAULT_MAX_DEPTH, discover_roms, iter_roms
+from packer.discovery.discsets import disc_set, set_stat
+from packer.discovery.ignore import PathFilter
+from packer.metadata.dat import DatIndex, open_dat_index
+from packer.metadata.titles import parse_rom_title, parse_title_name
+from packer.icons.match import find_icon_exact, find_icon_with_alts
+from packer.io.archive import copy_rom, real_path
+from packer.io.filelist import (
+    MANIFEST_NAME,
+    MANIFEST_OUTPUT_BASE,
+    ManifestEntry,
+    write_filelist,
+    write_manifest,
+)
+from packer.io.hashing import FileHashes, HashCache, hash_files, hash_one
 
 # NRO builder (use the refactor's module name; change to hbmenu if that's your layout)
 from packer.build.nro import build_nro_for_rom  # if your repo still uses hbmenu, swap to: from packer.build.hbmenu import build_nro_for_rom
 
+from packer.build.dedup import DEDUP_RULES, DEFAULT_DEDUP_PREFER, DuplicateGroup, find_duplicates, parse_rules
+from packer.build.cores import RETROARCH_NRO_PATHS, load_core_map, resolve_core_candidates
+from packer.build.index import BuildIndex, BuildRecord
+from packer.build.inventory import SDInventory, installed_core_candidates, load_sd_inventory
+from packer.build.playlist import PLAYLIST_DIR_NAME, PlaylistEntry, write_playlists
+from packer.io.deploy import (
+    NRO_DEST,
+    NSP_DEST,
+    PLAYLIST_DEST,
+    ROM_DEST,
+    check_destinations,
+    deploy,
+    plan_outputs,
+    plan_roms,
+    rom_sd_name,
+)
+from packer.io.serve import build_index, make_server
+from packer.io.watch import DEFAULT_DEBOUNCE, watch_tree
+
 # NSP forwarder builder (provided in packer/build/nsp.py)
 try:
     from packer.build.nsp import build_nsp_forwarder  # type: ignore
@@ -25,35 +59,176 @@ DEFAULT_OUT_DIR = Path(__file__).resolve().parent.parent / "out"
 DEFAULT_FILELIST = Path(__file__).resolve().parent.parent / "filelist.txt"
 
 
-def _prepare_romfs_for_single_rom(stub_dir: Path, platform: str, rom_path: Path) -> None:
+def _prepare_romfs_for_single_rom(
+    stub_dir: Path, platform: str, files: List[Tuple[Path, str, FileHashes]], subdir: str = ""
+) -> List[ManifestEntry]:
     """
-    Wipe stub/romfs, copy THIS ROM into RomFS, and write a one-line TAB-delimited manifest:
-        "<platform>\t<romfilename>\n"
-
-    The libnx stub will copy this embedded ROM to /roms/<platform>/<romfile> on first boot.
+    Wipe stub/romfs, copy THIS title's files into RomFS, and write the binary
+    extraction manifest (romfs:/manifest.bin) describing them.
+
+    files are (path, name relative to the title's folder, hashes): one ROM, or
+    a sheet followed by its tracks/discs. The libnx stub will copy them to
+    /roms/<platform>/<subdir>/<name> on first boot, keeping the set's subfolders.
+    A ROM inside an archive is streamed out of it straight into RomFS.
+    The manifest's size/CRC32 come from the (cached) hashes rather than
+    re-reading the copies. Returns the manifest entries.
     """
     romfs_dir = stub_dir / "romfs"
     if romfs_dir.exists():
         shutil.rmtree(romfs_dir)
     romfs_dir.mkdir(parents=True, exist_ok=True)
 
-    # Copy this ROM into RomFS (embed in the NRO)
-    shutil.copy2(rom_path, romfs_dir / rom_path.name)
+    entries: List[ManifestEntry] = []
+    for src, rel, hashes in files:
+        # Copy into RomFS (embed in the NRO)
+        dst = romfs_dir / rel
+        dst.parent.mkdir(parents=True, exist_ok=True)
+        copy_rom(src, dst)
+        sd_rel = posixpath.join(subdir, rel) if subdir else rel
+        entries.append(ManifestEntry(
+            platform=platform,
+            src=rel,
+            size=hashes.size,
+            crc32=hashes.crc32,
+            dest=f"{MANIFEST_OUTPUT_BASE}{platform}/{sd_rel}" if "/" in sd_rel else None,
+        ))
+    write_manifest(romfs_dir / MANIFEST_NAME, entries)
+    return entries
+
+
+def main(argv: list[str] | None = None) -> None:
+    argv = sys.argv[1:] if argv is None else argv
+    if argv and argv[0] in _SUBCOMMANDS:
+        # A ROM root that happens to be named like a command is still a ROM root
+        if not Path(argv[0]).is_dir():
+            return _SUBCOMMANDS[argv[0]](argv[1:])
+        print(f"[packer] '{argv[0]}' is a folder here, so it is used as rom_root; "
+              f"run the '{argv[0]}' command from another directory.")
+
+    ap = _build_parser("switch-rom-packer")
+    ap.epilog = f"Other commands: {', '.join(_SUBCOMMANDS)} (see '<command> --help')."
+    args = ap.parse_args(argv)
+
+    rom_root: Path = args.rom_root
+    out_dir: Path = args.output_dir
+    builder = _ItemBuilder(args)
+
+    # Keep the combined filelist (for inspection) and item metadata (alt_titles)
+    items: List[Dict[str, Any]] = []
+
+    # Discover ROMs; titles are parsed and their files hashed as paths stream
+    # in from the parallel walk. Builds start once the walk is done, since
+    # dedup and the SD path check need every title.
+    print("Visiting directories and calculating metadata...")
+    discovery_cache = DiscoveryCache.for_root(rom_root) if args.discovery_cache else None
+    t0 = time.monotonic()
+    walk_s = 0.0
+
+    def _discovered() -> Iterator[Path]:
+        nonlocal walk_s
+        for platform, rom_path in iter_roms(
+            rom_root, max_depth=args.scan_depth, cache=discovery_cache, path_filter=_path_filter(args)
+        ):
+            item = _parse_item(platform, _rom_source(rom_path, args.embed_archives), rom_root)
+            items.append(item)
+            yield item["rom_path"]
+        walk_s = time.monotonic() - t0
+
+    builder.prefetch_hashes(_discovered())
+
+    if discovery_cache is not None:
+        discovery_cache.save()
+        print(
+            f"[packer] Discovered {len(items)} ROM(s) in {walk_s:.2f}s "
+            f"({discovery_cache.hits} cached / {discovery_cache.misses} scanned directories)"
+        )
+    if not items:
+        print(f"[packer] No ROMs found under {rom_root}")
+        return
+
+    # Discovery order depends on thread timing; build in a stable order
+    items.sort(key=lambda it: (it["platform"], str(it["rom_path"])))
 
-    # TAB-delimited avoids issues when names contain spaces
-    (romfs_dir / "filelist.txt").write_text(
-        f"{platform}\t{rom_path.name}\n",
-        encoding="utf-8",
-        newline="\n",
+    # Identical payloads (same ROM in two folders, renamed copies) are built once
+    groups: List[DuplicateGroup] = []
+    if args.dedup:
+        items, groups = find_duplicates(items, builder.payload_key, args.dedup_prefer, rom_root)
+        _report_duplicates(groups)
+
+    # Nested folders keep their path on the SD card; refuse what would still collide
+    check_destinations(_rom_destinations(items))
+    # Combined filelist for inspection only; the stub reads romfs:/manifest.bin
+    write_filelist(args.filelist_out, sorted((it["platform"], it["sd_name"]) for it in items))
+
+    # Build per ROM; the index remembers what each ROM produced so outputs of
+    # ROMs that are gone (or were renamed, or are now duplicates) can be removed
+    index = BuildIndex.load(out_dir)
+    previous = set(index.records)
+    total = len(items)
+    t_build = time.monotonic()
+    for idx, item in enumerate(items, start=1):
+        rom = str(item["rom_path"])
+        index.replace(rom, builder.build(item, f"{idx}/{total}"))
+        previous.discard(rom)
+    for rom in sorted(previous):
+        index.drop(rom)
+    index.save()
+
+    skipped = sum(len(g.duplicates) for g in groups)
+    if skipped:
+        per_title = (time.monotonic() - t_build) / max(total, 1)
+        print(f"[dedup] Saved ~{per_title * skipped:.1f}s of builds ({per_title:.2f}s per title)")
+
+    if builder.skipped_nsp:
+        print(f"[packer] Skipped {builder.skipped_nsp} NSP forwarder(s) for platforms without an installed core.")
+    if args.playlists:
+        _write_playlists(out_dir, index, args.playlist_crc)
+    print("[packer] Done.")
+
+
+def _add_filter_args(ap: argparse.ArgumentParser) -> None:
+    ap.add_argument(
+        "--exclude",
+        action="append",
+        default=[],
+        metavar="PATTERN",
+        help="Skip ROMs and folders matching a .gitignore-style pattern relative to rom_root "
+             "(repeatable; overrides .packerignore files).",
+    )
+    ap.add_argument(
+        "--include",
+        action="append",
+        default=[],
+        metavar="PATTERN",
+        help="Only pack ROMs matching one of these patterns (repeatable), e.g. 'snes/**' or '*(USA)*'.",
     )
 
 
-def main(argv: list[str] | None = None) -> None:
-    ap = argparse.ArgumentParser(prog="switch-rom-packer")
+def _path_filter(args: argparse.Namespace) -> PathFilter:
+    return PathFilter(exclude=args.exclude, include=args.include)
+
+
+def _build_parser(prog: str) -> argparse.ArgumentParser:
+    """Build options shared by the default command and 'watch'."""
+    ap = argparse.ArgumentParser(prog=prog)
     ap.add_argument("rom_root", type=Path, help="Root folder containing platform folders with ROMs")
     ap.add_argument("--stub-dir", type=Path, default=DEFAULT_STUB_DIR)
     ap.add_argument("--output-dir", type=Path, default=DEFAULT_OUT_DIR)
     ap.add_argument("--filelist-out", type=Path, default=DEFAULT_FILELIST)
+    ap.add_argument(
+        "--scan-depth",
+        type=int,
+        default=DEFAULT_MAX_DEPTH,
+        help=f"Directory levels searched below each platform folder (default: {DEFAULT_MAX_DEPTH}).",
+    )
+    ap.add_argument(
+        "--discovery-cache",
+        dest="discovery_cache",
+        action=argparse.BooleanOptionalAction,
+        default=True,
+        help="Reuse listings of ROM folders whose mtime is unchanged since the last run (default: enabled).",
+    )
+    _add_filter_args(ap)
 
     # NRO build flags
     ap.add_argument(
@@ -90,6 +265,64 @@ def main(argv: list[str] | None = None) -> None:
         default=None,
         help="YAML file mapping <platform> -> <retroarch core nro path>. Used when --forwarder=retroarch.",
     )
+    ap.add_argument(
+        "--sd-inventory",
+        type=Path,
+        default=None,
+        help="Mounted SD card root, or a JSON list of sdmc:/ paths, describing the installed cores and "
+             "RetroArch NRO. Forwarders use the first cores.yml core that is present; platforms with none "
+             "are skipped.",
+    )
+    ap.add_argument(
+        "--dedup",
+        dest="dedup",
+        action=argparse.BooleanOptionalAction,
+        default=True,
+        help="Build ROMs with identical content (e.g. in both gb and gbc folders) only once (default: enabled).",
+    )
+    ap.add_argument(
+        "--dedup-prefer",
+        type=_dedup_rules,
+        default=DEFAULT_DEDUP_PREFER,
+        help=f"Which duplicate is built, as ordered rules from {', '.join(DEDUP_RULES)} "
+             f"(default: {DEFAULT_DEDUP_PREFER}).",
+    )
+    ap.add_argument(
+        "--embed-archives",
+        dest="embed_archives",
+        action="store_true",
+        help="Embed and deploy zipped ROMs as the .zip itself (RetroArch opens it) instead of "
+             "streaming the ROM out of the archive.",
+    )
+    ap.add_argument(
+        "--dat",
+        type=Path,
+        action="append",
+        default=[],
+        help="No-Intro/Redump DAT file, or a folder of them (repeatable). ROMs found in a DAT by checksum "
+             "get its exact title and thumbnail name.",
+    )
+    ap.add_argument(
+        "--hash-cache",
+        dest="hash_cache",
+        action=argparse.BooleanOptionalAction,
+        default=True,
+        help="Remember ROM hashes by device/inode/size/mtime so unchanged ROMs are never re-read (default: enabled).",
+    )
+    ap.add_argument(
+        "--playlists",
+        dest="playlists",
+        action=argparse.BooleanOptionalAction,
+        default=True,
+        help="Write RetroArch playlists to <output-dir>/playlists/<platform>.lpl (default: enabled).",
+    )
+    ap.add_argument(
+        "--playlist-crc",
+        dest="playlist_crc",
+        action=argparse.BooleanOptionalAction,
+        default=True,
+        help="Include each ROM's CRC32 in playlists for database/thumbnail matching (default: enabled).",
+    )
     ap.add_argument(
         "--titleid-base",
         type=str,
@@ -108,100 +341,452 @@ def main(argv: list[str] | None = None) -> None:
         default="logos",
         help="Choose thumbnail priority (default: logos).",
     )
+    return ap
 
-    args = ap.parse_args(argv)
 
-    rom_root: Path = args.rom_root
-    stub_dir: Path = args.stub_dir
-    out_dir: Path = args.output_dir
-    filelist_out: Path = args.filelist_out
+def _dedup_rules(spec: str) -> List[str]:
+    try:
+        return parse_rules(spec)
+    except ValueError as e:
+        raise argparse.ArgumentTypeError(str(e))
 
-    out_dir.mkdir(parents=True, exist_ok=True)
-    (out_dir / "nro").mkdir(parents=True, exist_ok=True)
-    if args.build_nsp:
-        (out_dir / "nsp").mkdir(parents=True, exist_ok=True)
 
-    # Discover ROMs
-    roms = discover_roms(rom_root)
-    if not roms:
-        print(f"[packer] No ROMs found under {rom_root}")
+def _report_duplicates(groups: List[DuplicateGroup]) -> None:
+    if not groups:
         return
+    for g in groups:
+        dups = ", ".join(str(d["rom_path"]) for d in g.duplicates)
+        print(f"[dedup] {g.canonical['rom_path']} (kept) = {dups}")
+    skipped = sum(len(g.duplicates) for g in groups)
+    saved = sum(g.bytes_saved for g in groups)
+    print(f"[dedup] Skipped {skipped} duplicate title(s) in {len(groups)} group(s): "
+          f"{saved / (1 << 20):.1f} MiB less payload")
+
+
+def _rom_source(rom_path: Path, embed_archives: bool) -> Path:
+    """With --embed-archives, a ROM found inside an archive is built from the archive file."""
+    return real_path(rom_path) if embed_archives else rom_path
+
+
+def _parse_item(platform: str, rom_path: Path, rom_root: Path) -> Dict[str, Any]:
+    # Original behavior: parse title + alt titles
+    canonical_title, alt_titles = parse_rom_title(str(rom_path))
+
+    # Debug logging for titles
+    if alt_titles:
+        preview = ", ".join(alt_titles[:4]) + ("..." if len(alt_titles) > 4 else "")
+        print(f"[titles] {rom_path.name} -> title='{canonical_title}' alt_titles=[{preview}]")
+    else:
+        print(f"[titles] {rom_path.name} -> title='{canonical_title}' (no alts)")
+    return {
+        "platform": platform,
+        "rom_path": rom_path,
+        "sd_name": rom_sd_name(rom_root, rom_path),
+        "title": canonical_title,
+        "alt_titles": alt_titles,
+    }
+
+
+class _ItemBuilder:
+    """Icon lookup, RomFS staging and NRO/NSP builds for one ROM at a time."""
+
+    def __init__(self, args: argparse.Namespace) -> None:
+        self.args = args
+        self.stub_dir: Path = args.stub_dir
+        self.out_dir: Path = args.output_dir
+        self.out_dir.mkdir(parents=True, exist_ok=True)
+        (self.out_dir / "nro").mkdir(parents=True, exist_ok=True)
+        if args.build_nsp:
+            (self.out_dir / "nsp").mkdir(parents=True, exist_ok=True)
+
+        self.sd_inventory: Optional[SDInventory] = None
+        if args.sd_inventory and args.build_nsp:
+            self.sd_inventory = _load_inventory(args.sd_inventory, args.core_map)
+        self.playlist_cores = _PlaylistCores(args.core_map, self.sd_inventory)
+        self.hash_cache: Optional[HashCache] = HashCache() if args.hash_cache else None
+        self._hashes: Dict[Path, FileHashes] = {}
+        self.dat: Optional[DatIndex] = open_dat_index(args.dat)
+        self.skipped_nsp = 0
+        self._nsp_ok: Dict[str, bool] = {}
+
+    def _nsp_enabled(self, platform: str) -> bool:
+        # Platforms without an installed core get no NSP forwarders (they would fail at launch)
+        if self.sd_inventory is None or self.args.forwarder != "retroarch":
+            return True
+        if platform not in self._nsp_ok:
+            self._nsp_ok[platform] = not _platforms_without_cores([platform], self.args.core_map, self.sd_inventory)
+        return self._nsp_ok[platform]
+
+    def prefetch_hashes(self, roms: Iterable[Path]) -> None:
+        """
+        Hash ROMs (every file of disc sets) up front, in parallel; unchanged
+        ones come from the hash cache. roms may be a generator still being
+        discovered: each title is queued as soon as it is yielded.
+        """
+        t0 = time.monotonic()
+        count = 0
+
+        def _paths() -> Iterator[Path]:
+            nonlocal count
+            for rom in roms:
+                try:
+                    files = [f for f, _ in disc_set(rom)]
+                except OSError:
+                    continue    # reported when the title is built
+                count += len(files)
+                yield from files
+
+        self._hashes.update(hash_files(_paths(), self.hash_cache))
+        if self.hash_cache is not None:
+            print(
+                f"[packer] Hashed {count} file(s) in {time.monotonic() - t0:.2f}s "
+                f"({self.hash_cache.hits} cached / {self.hash_cache.misses} read)"
+            )
 
-    # Keep the combined filelist (for inspection) and item metadata (alt_titles)
-    entries_for_filelist: List[Tuple[str, str]] = []
-    items: List[Dict[str, Any]] = []
-
-    print("Visiting directories...")
-    for platform, rom_path in roms:
-        # Original behavior: parse title + alt titles
-        canonical_title, alt_titles = parse_rom_title(str(rom_path))
-        items.append({
-            "platform": platform,
-            "rom_path": rom_path,
-            "title": canonical_title,
-            "alt_titles": alt_titles,
-        })
-        entries_for_filelist.append((platform, rom_path.name))
-
-        # Debug logging for titles
-        if alt_titles:
-            preview = ", ".join(alt_titles[:4]) + ("..." if len(alt_titles) > 4 else "")
-            print(f"[titles] {rom_path.name} -> title='{canonical_title}' alt_titles=[{preview}]")
-        else:
-            print(f"[titles] {rom_path.name} -> title='{canonical_title}' (no alts)")
-
-    # Write a combined filelist at repo root for inspection (stub still uses per-ROM filelist)
-    write_filelist(filelist_out, entries_for_filelist)
-
-    print("Calculating metadata...")
-
-    # Build per ROM
-    total = len(items)
-    for idx, item in enumerate(items, start=1):
+    def payload_key(self, item: Dict[str, Any]) -> Optional[Tuple[tuple, int]]:
+        """Content identity of a title (every file of a disc set, in order) and its size, from prefetched hashes."""
+        try:
+            files = disc_set(item["rom_path"])
+        except OSError:
+            return None
+        hashes = [self._hashes.get(f) for f, _ in files]
+        if any(h is None for h in hashes):
+            return None
+        return tuple((h.size, h.sha1) for h in hashes), sum(h.size for h in hashes)
+
+    def _rel(self, p: Path) -> str:
+        try:
+            return Path(p).relative_to(self.out_dir).as_posix()
+        except ValueError:
+            return str(p)
+
+    def build(self, item: Dict[str, Any], progress: str) -> BuildRecord:
+        args = self.args
         platform = item["platform"]
         rom_path: Path = item["rom_path"]
+        sd_name: str = item["sd_name"]
+        subdir = posixpath.dirname(sd_name)
         hb_title: str = item["title"]
         alt_titles: List[str] = item["alt_titles"]
+        files = [
+            (f, rel, self._hashes.pop(f, None) or hash_one(f, self.hash_cache)) for f, rel in disc_set(rom_path)
+        ]
+        st = set_stat(rom_path)
+        # The largest file (a disc set's data track) identifies the title in DATs and playlists
+        hashes = max((h for _, _, h in files), key=lambda h: h.size)
+
+        # A DAT hit gives the exact title and libretro thumbnail name; no fuzzy icon search
+        match = self.dat.lookup(hashes.crc32, hashes.sha1, hashes.size, platform) if self.dat else None
+        if match is not None:
+            hb_title, alt_titles = parse_title_name(match.game)
+            print(f"[dat] {rom_path.name} -> '{match.game}' ({match.system})")
+            icon_path = find_icon_exact(platform, match.thumbnail_name, preference=args.icon_preference)
+        else:
+            # Use correct parameter order via named args (and pass alt titles)
+            icon_path = find_icon_with_alts(
+                platform=platform,
+                primary_title=hb_title,
+                alt_titles=alt_titles,
+                source_name_hint=rom_path.name,
+                preference=args.icon_preference,
+            )
+        record = BuildRecord(platform=platform, title=hb_title, size=st.st_size, mtime_ns=st.st_mtime_ns)
 
-        # Use correct parameter order via named args (and pass alt titles)
-        icon_path = find_icon_with_alts(
-            platform=platform,
-            primary_title=hb_title,
-            alt_titles=alt_titles,
-            source_name_hint=rom_path.name,
-            preference=args.icon_preference,
-        )
-
-        # Prepare a fresh RomFS containing only THIS ROM
-        _prepare_romfs_for_single_rom(stub_dir, platform, rom_path)
+        # Prepare a fresh RomFS containing only THIS title
+        _prepare_romfs_for_single_rom(self.stub_dir, platform, files, subdir)
+        if args.playlists:
+            record.playlist = PlaylistEntry(
+                platform=platform,
+                dest=f"/{ROM_DEST}/{platform}/{sd_name}",
+                label=match.game if match is not None else hb_title,
+                crc32=hashes.crc32,
+                core_path=self.playlist_cores.get(platform),
+                thumbnail=match.thumbnail_name if match is not None else None,
+            )
 
         # Build NRO
         if args.build_nro:
-            nro_out = build_nro_for_rom(stub_dir, out_dir, platform, rom_path, hb_title, icon_path)
-            print(f"[{idx}/{total}] Built NRO for {hb_title} -> {nro_out}")
+            nro_out = build_nro_for_rom(
+                self.stub_dir, self.out_dir, platform, rom_path, hb_title, icon_path, subdir=subdir
+            )
+            record.outputs.append(self._rel(nro_out))
+            print(f"[{progress}] Built NRO for {hb_title} -> {nro_out}")
 
         # Build NSP
-        if args.build_nsp:
+        if args.build_nsp and not self._nsp_enabled(platform):
+            self.skipped_nsp += 1
+        elif args.build_nsp:
             if build_nsp_forwarder is None:
                 raise SystemExit(
                     "[packer] --build-nsp is enabled but packer.build.nsp.build_nsp_forwarder is missing. "
                     "Add packer/build/nsp.py first."
                 )
             nsp_out = build_nsp_forwarder(
-                stub_dir=stub_dir,
-                out_dir=out_dir / "nsp",
+                stub_dir=self.stub_dir,
+                out_dir=self.out_dir / "nsp",
                 platform=platform,
                 rom_path=rom_path,
+                rom_name=sd_name,
                 hb_title=hb_title,
                 icon_path=icon_path,
                 keys_path=args.keys,
                 forwarder_mode=args.forwarder,
                 core_map_path=args.core_map,
                 titleid_base=args.titleid_base,
+                sd_inventory=self.sd_inventory,
             )
-            print(f"[{idx}/{total}] Built NSP forwarder for {hb_title} -> {nsp_out}")
+            record.outputs.append(self._rel(nsp_out))
+            print(f"[{progress}] Built NSP forwarder for {hb_title} -> {nsp_out}")
+        return record
+
+
+def _rom_destinations(items: List[Dict[str, Any]]) -> List[Tuple[str, Path]]:
+    return [(f"{ROM_DEST}/{it['platform']}/{it['sd_name']}", it["rom_path"]) for it in items]
+
+
+def _write_playlists(out_dir: Path, index: BuildIndex, with_crc: bool, platforms: Optional[set[str]] = None) -> None:
+    """(Re)write playlists for platforms (default: all), removing those left without ROMs."""
+    playlist_dir = out_dir / PLAYLIST_DIR_NAME
+    entries = index.playlist_entries(platforms)
+    written = write_playlists(playlist_dir, entries, with_crc=with_crc)
+    if platforms is None:
+        platforms = {p.stem for p in playlist_dir.glob("*.lpl")}
+    for platform in platforms - {e.platform for e in entries}:
+        (playlist_dir / f"{platform}.lpl").unlink(missing_ok=True)
+    if written:
+        print(f"[packer] Wrote {len(written)} RetroArch playlist(s) to {playlist_dir}")
+
+
+class _PlaylistCores:
+    """Per-platform playlist core: first installed candidate with --sd-inventory, else the first listed."""
+
+    def __init__(self, core_map_path: Optional[Path], inventory: Optional[SDInventory]) -> None:
+        self._core_map = load_core_map(core_map_path)
+        self._inventory = inventory
+        self._cache: Dict[str, Optional[str]] = {}
+
+    def get(self, platform: str) -> Optional[str]:
+        if platform not in self._cache:
+            if self._inventory is not None:
+                candidates = installed_core_candidates(platform, self._core_map, self._inventory)
+            else:
+                candidates = resolve_core_candidates(platform, self._core_map)
+            self._cache[platform] = candidates[0] if candidates else None
+        return self._cache[platform]
+
+
+def _load_inventory(path: Path, core_map_path: Optional[Path]) -> SDInventory:
+    inventory = load_sd_inventory(path, load_core_map(core_map_path))
+    print(f"[packer] SD inventory: {len(inventory.files)} installed file(s) from {inventory.source}")
+    if not inventory.first_present(RETROARCH_NRO_PATHS):
+        print(f"[packer] WARNING: no RetroArch NRO in SD inventory (looked for {', '.join(RETROARCH_NRO_PATHS)})")
+    return inventory
+
+
+def _platforms_without_cores(platforms: List[str], core_map_path: Optional[Path], inventory: SDInventory) -> set[str]:
+    core_map = load_core_map(core_map_path)
+    missing: set[str] = set()
+    for platform in platforms:
+        if installed_core_candidates(platform, core_map, inventory):
+            continue
+        missing.add(platform)
+        tried = [c.rsplit("/", 1)[-1] for c in resolve_core_candidates(platform, core_map)]
+        print(
+            f"[packer] WARNING: no installed core for {platform!r} "
+            f"(tried: {', '.join(tried) or 'none listed in cores.yml'}); skipping its NSP forwarders."
+        )
+    return missing
 
-    print("[packer] Done.")
+
+def _deploy_main(argv: list[str]) -> None:
+    ap = argparse.ArgumentParser(
+        prog="switch-rom-packer deploy",
+        description="Copy new/changed packer output to a mounted SD card or install dir and remove orphans.",
+    )
+    ap.add_argument("target", type=Path, help="Mounted SD card root (or install target directory)")
+    ap.add_argument("--output-dir", type=Path, default=DEFAULT_OUT_DIR, help="Packer output to deploy (nro/, nsp/, playlists/)")
+    ap.add_argument("--rom-root", type=Path, default=None,
+                    help="Also deploy discovered ROMs to /roms/<platform>/ (needed by NSP forwarders)")
+    ap.add_argument("--embed-archives", action="store_true",
+                    help="Deploy zipped ROMs as the .zip itself (use when the packer run did)")
+    ap.add_argument("--jobs", type=int, default=4, help="Parallel copies (default: 4)")
+    _add_filter_args(ap)
+    ap.add_argument("--keep-orphans", action="store_true",
+                    help="Don't delete files from earlier deploys that are no longer produced")
+    ap.add_argument("--dry-run", action="store_true", help="Only report what would change")
+    args = ap.parse_args(argv)
+
+    if not args.target.is_dir():
+        raise SystemExit(f"[deploy] Target is not a directory: {args.target}")
+
+    items = plan_outputs(args.output_dir)
+    scope = [NRO_DEST, NSP_DEST, PLAYLIST_DEST]
+    if args.rom_root:
+        cache = DiscoveryCache.for_root(args.rom_root)
+        roms = discover_roms(args.rom_root, cache=cache, path_filter=_path_filter(args))
+        items += plan_roms(((plat, _rom_source(p, args.embed_archives)) for plat, p in roms), args.rom_root)
+        cache.save()
+        scope.append(ROM_DEST)
+    print(f"[deploy] {len(items)} file(s) -> {args.target}")
+
+    t0 = time.monotonic()
+    stats = deploy(
+        items,
+        args.target,
+        jobs=args.jobs,
+        delete_orphans=not args.keep_orphans,
+        orphan_scope=scope,
+        dry_run=args.dry_run,
+    )
+    print(
+        f"[deploy] {stats.copied} copied ({stats.bytes_copied / (1 << 20):.1f} MiB), "
+        f"{stats.unchanged} unchanged, {stats.deleted} deleted, {stats.failed} failed "
+        f"in {time.monotonic() - t0:.1f}s"
+    )
+    if stats.failed:
+        raise SystemExit(1)
+
+
+def _serve_main(argv: list[str]) -> None:
+    ap = argparse.ArgumentParser(
+        prog="switch-rom-packer serve",
+        description="Serve packer output (NSPs/NROs + index.json) over HTTP for network installers.",
+    )
+    ap.add_argument("--output-dir", type=Path, default=DEFAULT_OUT_DIR, help="Directory to serve (default: ./out)")
+    ap.add_argument("--host", default="0.0.0.0", help="Bind address (default: all interfaces)")
+    ap.add_argument("--port", type=int, default=8000)
+    args = ap.parse_args(argv)
+
+    if not args.output_dir.is_dir():
+        raise SystemExit(f"[serve] Output dir not found: {args.output_dir}")
+    server = make_server(args.output_dir, args.host, args.port)
+    host, port = server.server_address[:2]
+    count = len(build_index(args.output_dir.resolve())["files"])
+    print(f"[serve] {count} title file(s) from {args.output_dir} at http://{host}:{port}/ (index: /index.json)")
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        server.server_close()
+
+
+def _watch_main(argv: list[str]) -> None:
+    ap = _build_parser("switch-rom-packer watch")
+    ap.description = (
+        "Build, then watch rom_root and rebuild only the ROMs that were added or changed; "
+        "outputs of removed ROMs are deleted."
+    )
+    ap.add_argument("--debounce", type=float, default=DEFAULT_DEBOUNCE,
+                    help=f"Seconds without changes before rebuilding (default: {DEFAULT_DEBOUNCE:g})")
+    args = ap.parse_args(argv)
+    if not args.rom_root.is_dir():
+        raise SystemExit(f"[watch] ROM root is not a directory: {args.rom_root}")
+
+    builder = _ItemBuilder(args)
+    index = BuildIndex.load(args.output_dir)
+    # The watcher needs the folder listing on every change, so it always caches it.
+    cache = DiscoveryCache.for_root(args.rom_root)
+
+    # Catch up with whatever changed while nobody was watching, then follow events.
+    _sync(args, builder, index, cache, written=None)
+    try:
+        for batch in watch_tree(args.rom_root, args.scan_depth, debounce=args.debounce):
+            # Polling and overflowed event queues only say "something changed": compare size/mtime
+            written = None if batch.rescan else {str(p) for p in batch.written}
+            _sync(args, builder, index, cache, written=written)
+    except KeyboardInterrupt:
+        print("[watch] Stopped.")
+
+
+def _sync(
+    args: argparse.Namespace,
+    builder: _ItemBuilder,
+    index: BuildIndex,
+    cache: DiscoveryCache,
+    written: Optional[set[str]],
+) -> None:
+    """
+    Bring the output dir in line with rom_root: build ROMs that are new, moved
+    to another platform, or changed (in written, or with a different size/mtime
+    than recorded when written is None), and drop ROMs that are gone.
+    """
+    current = {
+        str(_rom_source(p, args.embed_archives)): plat
+        for plat, p in discover_roms(args.rom_root, args.scan_depth, cache=cache, path_filter=_path_filter(args))
+    }
+    cache.save()
+    if args.dedup:
+        # Duplicates count as absent, so they are only built once their original is gone
+        items = [{"platform": plat, "rom_path": Path(rom)} for rom, plat in sorted(current.items())]
+        builder.prefetch_hashes([it["rom_path"] for it in items])
+        keep, _ = find_duplicates(items, builder.payload_key, args.dedup_prefer, args.rom_root)
+        current = {str(it["rom_path"]): it["platform"] for it in keep}
+    try:
+        check_destinations(
+            (f"{ROM_DEST}/{plat}/{rom_sd_name(args.rom_root, Path(rom))}", Path(rom))
+            for rom, plat in sorted(current.items())
+        )
+    except SystemExit as e:
+        # Keep watching; the next change may resolve the clash
+        print(f"[watch] ERROR: {e}")
+        return
+
+    gone = [rom for rom, rec in index.records.items() if current.get(rom) != rec.platform]
+    todo: List[Tuple[str, str]] = []
+    for rom, platform in sorted(current.items()):
+        rec = index.records.get(rom)
+        if rec is None or rec.platform != platform:
+            todo.append((rom, platform))
+        elif written is not None:
+            if not written.isdisjoint(_files_on_disk(rom)):
+                todo.append((rom, platform))
+        else:
+            try:
+                if not rec.is_current(set_stat(Path(rom))):
+                    todo.append((rom, platform))
+            except OSError:
+                continue
+    if not gone and not todo:
+        return
+
+    affected = {index.records[rom].platform for rom in gone}
+    for rom in gone:
+        print(f"[watch] Removed: {rom}")
+        index.drop(rom)
+    for idx, (rom, platform) in enumerate(todo, start=1):
+        affected.add(platform)
+        try:
+            record = builder.build(_parse_item(platform, Path(rom), args.rom_root), f"{idx}/{len(todo)}")
+        except (Exception, SystemExit) as e:
+            # Builders exit on toolchain errors; keep watching and retry on the next change.
+            print(f"[watch] ERROR: build failed for {rom}: {e}")
+            continue
+        index.replace(rom, record)
+    index.save()
+
+    write_filelist(
+        args.filelist_out,
+        sorted((rec.platform, rom_sd_name(args.rom_root, Path(rom))) for rom, rec in index.records.items()),
+    )
+    if args.playlists:
+        _write_playlists(args.output_dir, index, args.playlist_crc, affected)
+    print(f"[watch] {len(todo)} rebuilt, {len(gone)} removed; {len(index.records)} title(s) in {args.output_dir}")
+
+
+def _files_on_disk(rom: str) -> set[str]:
+    """Paths watch events name for a title: the archive of a zipped ROM, every file of a disc set."""
+    try:
+        return {str(real_path(f)) for f, _ in disc_set(Path(rom))}
+    except OSError:
+        return {rom}
+
+
+_SUBCOMMANDS = {
+    "deploy": _deploy_main,
+    "serve": _serve_main,
+    "watch": _watch_main,
+}
 
 
 if __name__ == "__main__":
@@ -0,0 +1,148 @@
+# packer/discovery/cache.py
+from __future__ import annotations
+
+import hashlib
+import json
+import os
+import threading
+from pathlib import Path
+from typing import Callable, Dict, List, Optional, Tuple
+
+from packer.io.fsutil import atomic_write_text
+
+from .systems import ALIASES, GENERIC_EXTS, HEADER_SIGNATURES, PLATFORM_EXTS
+
+# Cache root: ~/.switch-rom-packer/cache/discovery/<hash of rom_root>.json
+DEFAULT_CACHE_DIR = Path.home() / ".switch-rom-packer" / "cache" / "discovery"
+CACHE_VERSION = 5
+
+# One scanned directory: its mtime, the ROM files classified in it as
+# (name, platform, size, mtime_ns, disc set parts) and the subdirectories to
+# walk as (name, platform). Unclassified entries, and files that belong to a
+# sheet's disc set, are not stored.
+FileRow = Tuple[str, str, int, int, List[str]]
+DirRow = Tuple[str, str]
+
+# A directory modified this recently may change again within the same mtime
+# tick (coarse on FAT/SMB), so its listing is not cached yet.
+RACY_WINDOW_NS = 2_000_000_000
+
+
+def _probe_identity(probe: object) -> str:
+    """
+    A probe's name, bytecode, constants and closure values, so magic_at()
+    lambdas (which share one qualname) differ by offset/magic and editing a
+    probe's body counts as a rule change. Helpers a probe calls are not
+    covered; bump CACHE_VERSION when changing those.
+    """
+    parts = [getattr(probe, "__qualname__", type(probe).__qualname__)]
+    code = getattr(probe, "__code__", None)
+    if code is not None:
+        parts.append(code.co_code.hex())
+        parts += [repr(c) for c in code.co_consts if not hasattr(c, "co_code")]
+    parts += [repr(cell.cell_contents) for cell in getattr(probe, "__closure__", None) or ()]
+    return hashlib.sha1("\0".join(parts).encode("utf-8", "surrogateescape")).hexdigest()[:16]
+
+
+def _rules_fingerprint() -> str:
+    """Changing extensions, aliases or header signatures reclassifies entries, so it invalidates the cache."""
+    signatures = [(s.platform, _probe_identity(s.probe)) for s in HEADER_SIGNATURES]
+    rules = json.dumps(
+        [sorted(PLATFORM_EXTS.items()), sorted(ALIASES.items()), signatures, sorted(GENERIC_EXTS)]
+    )
+    return hashlib.sha1(rules.encode("utf-8")).hexdigest()[:16]
+
+
+class DiscoveryCache:
+    """
+    Per-directory scan results for one ROM root, keyed on the directory's
+    mtime. A directory's mtime changes whenever an entry is added, removed or
+    renamed in it, so an unchanged mtime means its listing can be reused
+    without reading it; only a stat of the directory itself is needed.
+    A file rewritten in place does not change its directory's mtime, so rows
+    classified from file contents are checked against their stored
+    size/mtime by the caller's validator (see lookup).
+    """
+
+    def __init__(self, path: Path, root: str = "", dirs: Optional[Dict[str, dict]] = None) -> None:
+        self.path = Path(path)
+        self.root = root
+        self._dirs: Dict[str, dict] = dirs or {}
+        self._seen: set[str] = set()
+        self._dirty = False
+        self._lock = threading.Lock()
+        self.hits = 0
+        self.misses = 0
+
+    @classmethod
+    def for_root(cls, rom_root: Path, cache_dir: Path = DEFAULT_CACHE_DIR) -> "DiscoveryCache":
+        root = str(Path(rom_root).resolve())
+        path = Path(cache_dir) / (hashlib.sha1(root.encode("utf-8")).hexdigest()[:16] + ".json")
+        return cls.load(path, root)
+
+    @classmethod
+    def load(cls, path: Path, root: str = "") -> "DiscoveryCache":
+        try:
+            data = json.loads(Path(path).read_text(encoding="utf-8"))
+        except FileNotFoundError:
+            return cls(path, root)
+        except (OSError, ValueError) as e:
+            print(f"[discover] Ignoring unreadable cache {path}: {e}")
+            return cls(path, root)
+        if (
+            not isinstance(data, dict)
+            or data.get("version") != CACHE_VERSION
+            or data.get("rules") != _rules_fingerprint()
+            or data.get("root") != root
+            or not isinstance(data.get("dirs"), dict)
+        ):
+            return cls(path, root)
+        return cls(path, root, data["dirs"])
+
+    def lookup(
+        self,
+        dir_path: str,
+        mtime_ns: int,
+        valid: Optional[Callable[[List[FileRow]], bool]] = None,
+    ) -> Optional[Tuple[List[FileRow], List[DirRow], bool]]:
+        """Cached listing, or None when the directory changed or valid() rejects its rows."""
+        with self._lock:
+            self._seen.add(dir_path)
+            entry = self._dirs.get(dir_path)
+        if entry is None or entry.get("mtime_ns") != mtime_ns or (valid is not None and not valid(entry["files"])):
+            with self._lock:
+                self.misses += 1
+            return None
+        with self._lock:
+            self.hits += 1
+        # Rows come back as JSON lists; callers only unpack them.
+        return entry["files"], entry["dirs"], entry.get("ignore", False)
+
+    def store(
+        self, dir_path: str, mtime_ns: int, files: List[FileRow], dirs: List[DirRow], has_ignore: bool = False
+    ) -> None:
+        with self._lock:
+            self._seen.add(dir_path)
+            self._dirs[dir_path] = {"mtime_ns": mtime_ns, "files": files, "dirs": dirs, "ignore": has_ignore}
+            self._dirty = True
+
+    def save(self) -> None:
+        """Persist, dropping directories that were not visited by this run. No-op if nothing changed."""
+        with self._lock:
+            dirs = {k: v for k, v in self._dirs.items() if k in self._seen}
+            if not self._dirty and len(dirs) == len(self._dirs) and self.path.exists():
+                return
+        doc = {
+            "version": CACHE_VERSION,
+            "rules": _rules_fingerprint(),
+            "root": self.root,
+            "dirs": dirs,
+        }
+        atomic_write_text(self.path, json.dumps(doc, separators=(",", ":")))
+
+
+def dir_mtime_ns(dir_path: str) -> Optional[int]:
+    try:
+        return os.stat(dir_path).st_mtime_ns
+    except OSError:
+        return None
@@ -1,64 +1,297 @@
 # packer/discovery/detect.py
 from __future__ import annotations
 
+import os
+import time
+from concurrent.futures import FIRST_COMPLETED, Future, ThreadPoolExecutor, wait
 from pathlib import Path
-from typing import List, Tuple
+from typing import Dict, Iterable, Iterator, List, Optional, Set, Tuple
 
-from .systems import PLATFORM_EXTS, EXT_TO_PLAT, resolve_platform
+from packer.io.archive import is_archive_name, pick_member
 
+from .cache import RACY_WINDOW_NS, DirRow, DiscoveryCache, FileRow, dir_mtime_ns
+from .discsets import is_sheet, set_parts
+from .ignore import IGNORE_FILE, IgnoreChain, IgnoreRules, PathFilter, load_ignore_file
+from .systems import PLATFORM_EXTS, EXT_TO_PLAT, is_ambiguous_ext, resolve_platform, sniff_platform
 
-def _list_roms_in_dir_for_platform(dir_path: Path, platform: str) -> List[Path]:
-    exts = set(PLATFORM_EXTS.get(platform, ()))
-    out: List[Path] = []
-    for p in dir_path.iterdir():
-        if p.is_file() and p.suffix.lower() in exts:
-            out.append(p)
-    return out
+# Directory levels below a platform folder that are searched, e.g. depth 1
+# covers <platform>/<letter>/<file>. 0 = the platform folder only.
+DEFAULT_MAX_DEPTH = 4
+# Directory scans are I/O bound (and mostly latency on a NAS), not CPU bound.
+DEFAULT_SCAN_JOBS = 8
 
 
-def _infer_platform_from_ext(p: Path) -> str | None:
-    """For flat layouts: infer platform by file extension if unambiguous."""
-    plats = EXT_TO_PLAT.get(p.suffix.lower())
+def _scan_dir(dir_path: str, platform: Optional[str], with_stat: bool) -> Tuple[List[FileRow], List[DirRow], bool]:
+    """
+    One scandir pass over a directory. For the ROM root (platform None), files
+    get their platform from the extension (or header) and subfolders from their name; below
+    a platform folder, files must match its extensions and every subfolder
+    inherits it. DirEntry type checks use the d_type cached by scandir, so no
+    per-entry stat on most filesystems (with_stat adds one per ROM, for the
+    cache's size/mtime). Symlinked directories are only followed at the root.
+    A .zip that is not itself a ROM of the platform is listed as its member
+    path ("Foo.zip/Foo.sfc") if its central directory names a matching ROM.
+    Cue/gdi/m3u sheets are read so the tracks and discs they reference are
+    listed as parts of the sheet's row rather than as titles of their own;
+    a flat sheet whose platform is ambiguous is skipped together with them.
+    The last element tells whether the directory has a .packerignore.
+    """
+    exts = frozenset(PLATFORM_EXTS.get(platform, ())) if platform else frozenset()
+    files: List[FileRow] = []
+    dirs: List[DirRow] = []
+    orphan_sheets: List[str] = []
+    has_ignore = False
+    try:
+        with os.scandir(dir_path) as it:
+            for entry in it:
+                if entry.name.startswith("."):
+                    has_ignore = has_ignore or entry.name == IGNORE_FILE
+                    continue
+                if entry.is_file():
+                    name = entry.name
+                    ext = os.path.splitext(name)[1].lower()
+                    if platform is None and is_sheet(name) and len(EXT_TO_PLAT.get(ext, ())) > 1:
+                        # Sheets are text: no header tells .cue platforms apart
+                        orphan_sheets.append(name)
+                        continue
+                    if platform is None:
+                        plat = _infer_platform(entry.path, ext)
+                    else:
+                        plat = platform if ext in exts else None
+                    if plat is None and is_archive_name(name):
+                        plat, member = _archive_rom(entry.path, platform, exts)
+                        if member:
+                            name = f"{name}/{member}"
+                    if plat:
+                        st = entry.stat() if with_stat else None
+                        files.append((name, plat, st.st_size if st else 0, st.st_mtime_ns if st else 0, []))
+                elif platform is None:
+                    if entry.is_dir():
+                        plat = resolve_platform(entry.name)
+                        if plat:
+                            dirs.append((entry.name, plat))
+                elif entry.is_dir(follow_symlinks=False):
+                    dirs.append((entry.name, platform))
+    except OSError as e:
+        print(f"[discover] Skipping unreadable directory {dir_path}: {e}")
+    if orphan_sheets or any(is_sheet(row[0]) for row in files):
+        files = _group_disc_sets(dir_path, files, orphan_sheets)
+    return files, dirs, has_ignore
+
+
+def _group_disc_sets(dir_path: str, files: List[FileRow], orphan_sheets: Iterable[str] = ()) -> List[FileRow]:
+    """
+    Attach each sheet's parts to its row and drop the rows it claims; incomplete
+    sets are dropped whole. orphan_sheets (no platform) still claim their parts,
+    so a flat Game.cue never leaves its Game.bin to be listed as a Genesis ROM.
+    """
+    parts: Dict[str, List[str]] = {}
+    for name, *_ in files:
+        if is_sheet(name):
+            found = set_parts(os.path.join(dir_path, name))
+            if found is not None:
+                parts[name] = found
+    claimed = {p for found in parts.values() for p in found}
+    for name in orphan_sheets:
+        found = set_parts(os.path.join(dir_path, name)) or []
+        claimed.update(found)
+        plats = ", ".join(sorted(EXT_TO_PLAT[os.path.splitext(name)[1].lower()]))
+        print(
+            f"[discover] {name}: could be {plats}; skipped with its {len(found)} file(s) "
+            "(move the set into a platform folder)"
+        )
+    return [
+        (name, plat, size, mtime, parts.get(name, []))
+        for name, plat, size, mtime, _ in files
+        if name not in claimed and (name in parts or not is_sheet(name))
+    ]
+
+
+def _list_dir(
+    dir_path: str, key: str, platform: Optional[str], cache: Optional[DiscoveryCache]
+) -> Tuple[List[FileRow], List[DirRow], Optional[IgnoreRules]]:
+    """
+    _scan_dir, answered from the cache when the directory's mtime is
+    unchanged, plus the directory's .packerignore rules. Those are always
+    read fresh: editing the file does not change the directory's mtime.
+    """
+    if cache is None:
+        files, dirs, has_ignore = _scan_dir(dir_path, platform, with_stat=False)
+    else:
+        mtime = dir_mtime_ns(dir_path)
+        if mtime is None:
+            return [], [], None
+        hit = cache.lookup(key, mtime, lambda rows: _rows_current(dir_path, rows, platform))
+        if hit is not None:
+            files, dirs, has_ignore = hit
+        else:
+            files, dirs, has_ignore = _scan_dir(dir_path, platform, with_stat=True)
+            if time.time_ns() - mtime > RACY_WINDOW_NS:
+                cache.store(key, mtime, files, dirs, has_ignore)
+    rules = load_ignore_file(dir_path, "" if key == "." else key) if has_ignore else None
+    return files, dirs, rules
+
+
+def _rows_current(dir_path: str, files: List[FileRow], platform: Optional[str]) -> bool:
+    """
+    Whether cached rows still hold for files rewritten in place (which leaves
+    the directory mtime alone). Only rows classified from contents can go
+    stale: sheets (and the parts they list, which may live in subfolders),
+    archive members and header-sniffed flat files. One stat each.
+    """
+    for name, _plat, size, mtime_ns, parts in files:
+        disk = name.split("/", 1)[0]
+        sniffed = platform is None and is_ambiguous_ext(os.path.splitext(name)[1])
+        if not (parts or disk != name or is_sheet(name) or sniffed):
+            continue
+        try:
+            st = os.stat(os.path.join(dir_path, disk))
+        except OSError:
+            return False
+        if st.st_size != size or st.st_mtime_ns != mtime_ns:
+            return False
+        if not all(os.path.isfile(os.path.join(dir_path, p)) for p in parts):
+            return False
+    return True
+
+
+def _infer_platform(path: str, ext: str) -> str | None:
+    """
+    For flat layouts: infer platform by file extension, or from the file's
+    header when the extension is shared or generic (e.g. .bin) — never a guess.
+    """
+    plats = EXT_TO_PLAT.get(ext.lower())
     if not plats:
         return None
-    if len(plats) == 1:
+    if not is_ambiguous_ext(ext):
         return next(iter(plats))
-    # Ambiguous ext (e.g., .bin used by multiple) — don’t guess
-    return None
+    plat = sniff_platform(Path(path), plats)
+    if plat is None:
+        print(f"[discover] {os.path.basename(path)}: no known header for {', '.join(sorted(plats))}; skipped")
+    return plat
+
+
+def _known_by_extension(name: str) -> bool:
+    ext = os.path.splitext(name)[1].lower()
+    return ext in EXT_TO_PLAT and not is_ambiguous_ext(ext) and not is_sheet(name)
 
 
-def discover_roms(rom_root: Path) -> List[Tuple[str, Path]]:
+def _archive_rom(path: str, platform: Optional[str], exts: frozenset) -> Tuple[Optional[str], Optional[str]]:
     """
-    Discover ROMs either under <rom_root>/<platform_dir>/file
-    (where platform_dir can be exact or an alias) OR directly under
-    <rom_root> (flat), in which case we infer platform from extension when unambiguous.
+    (platform, member) for the ROM inside an archive: a member with one of
+    the platform's extensions, or for flat layouts one whose extension
+    alone identifies the platform (members can't be header-sniffed without
+    decompressing them). Disc sets inside archives are not supported.
     """
-    rom_root = Path(rom_root)
-    results: List[Tuple[str, Path]] = []
+    if platform is not None:
+        member = pick_member(path, lambda n: os.path.splitext(n)[1].lower() in exts and not is_sheet(n))
+        return (platform, member) if member else (None, None)
+    member = pick_member(path, _known_by_extension)
+    if member is None:
+        return None, None
+    return next(iter(EXT_TO_PLAT[os.path.splitext(member)[1].lower()])), member
 
-    if not rom_root.exists():
-        return results
 
-    # 1) Platform subdirectories (exact or alias)
-    for entry in rom_root.iterdir():
-        if not entry.is_dir():
-            continue
-        plat = resolve_platform(entry.name)
-        if not plat:
-            continue
-        roms = _list_roms_in_dir_for_platform(entry, plat)
-        if roms:
-            # Optional: noisy debug here if needed
-            # print(f"[discover] {entry.name} -> {plat} ({len(roms)} ROMs)")
-            for r in roms:
-                results.append((plat, r))
-
-    # 2) Flat files directly in rom_root (infer by extension)
-    for p in rom_root.iterdir():
-        if not p.is_file():
-            continue
-        plat = _infer_platform_from_ext(p)
-        if plat:
-            results.append((plat, p))
+def _iter_rom_paths(
+    rom_root: Path,
+    max_depth: int,
+    jobs: int,
+    cache: Optional[DiscoveryCache],
+    path_filter: Optional[PathFilter] = None,
+) -> Iterator[Tuple[str, str]]:
+    """iter_roms with plain string paths (Path objects are costly at 100k+ files)."""
+    root = str(rom_root)
+    if not os.path.isdir(root):
+        return
+    filt = path_filter or PathFilter()
+
+    # Files a sheet in a parent folder pulled in (e.g. discs in a subfolder of
+    # an .m3u); parents are always listed before their subfolders.
+    claimed: Set[str] = set()
+
+    def _rows(dir_path: str, key: str, files: List[FileRow], chain: IgnoreChain) -> Iterator[Tuple[str, str]]:
+        prefix = "" if key == "." else key + "/"
+        for name, plat, _size, _mtime, parts in files:
+            path = os.path.join(dir_path, name)
+            if claimed and path in claimed:
+                continue
+            # Archive members are matched by their archive's name (and, for --include, their own)
+            disk = name.split("/", 1)[0]
+            if filt.file_ignored(chain, prefix + disk, prefix + name):
+                continue
+            claimed.update(os.path.join(dir_path, p) for p in parts if "/" in p)
+            yield plat, path
+
+    # 1) Flat files directly in rom_root (infer by extension)
+    files, platform_dirs, rules = _list_dir(root, ".", None, cache)
+    root_chain = IgnoreChain().child(rules)
+    yield from _rows(root, ".", files, root_chain)
+
+    # 2) Platform subdirectories (exact or alias), walked breadth-first in parallel.
+    # Ignored folders are pruned here, before they are ever listed.
+    pool = ThreadPoolExecutor(max_workers=max(1, jobs), thread_name_prefix="discover")
+    pending: Set[Future] = set()
+    meta: Dict[Future, Tuple[str, str, int, IgnoreChain]] = {}
+
+    def _submit(path: str, key: str, plat: str, depth: int, chain: IgnoreChain) -> None:
+        if filt.dir_ignored(chain, key):
+            return
+        fut = pool.submit(_list_dir, path, key, plat, cache)
+        meta[fut] = (path, key, depth, chain)
+        pending.add(fut)
 
-    return results
+    try:
+        for name, plat in platform_dirs:
+            _submit(os.path.join(root, name), name, plat, 0, root_chain)
+        while pending:
+            done, _ = wait(pending, return_when=FIRST_COMPLETED)
+            for fut in done:
+                pending.discard(fut)
+                path, key, depth, parent_chain = meta.pop(fut)
+                files, subdirs, rules = fut.result()
+                chain = parent_chain.child(rules)
+                if depth < max_depth:
+                    for name, plat in subdirs:
+                        _submit(os.path.join(path, name), f"{key}/{name}", plat, depth + 1, chain)
+                yield from _rows(path, key, files, chain)
+    finally:
+        pool.shutdown(wait=True, cancel_futures=True)
+
+
+def iter_roms(
+    rom_root: Path,
+    max_depth: int = DEFAULT_MAX_DEPTH,
+    jobs: int = DEFAULT_SCAN_JOBS,
+    cache: Optional[DiscoveryCache] = None,
+    path_filter: Optional[PathFilter] = None,
+) -> Iterator[Tuple[str, Path]]:
+    """
+    Stream (platform, path) pairs as they are found. Platform folders (exact
+    name or alias) directly under rom_root are walked up to max_depth levels
+    deep, sibling directories concurrently; files directly in rom_root get
+    their platform from the extension when unambiguous. ROMs inside .zip
+    archives come back as member paths (see packer.io.archive). With a cache, only
+    directories whose mtime changed are read (call cache.save() afterwards).
+    .packerignore files and path_filter's --exclude/--include patterns prune
+    folders before they are listed. Order is not stable; use discover_roms
+    for a sorted list.
+    """
+    for plat, path in _iter_rom_paths(rom_root, max_depth, jobs, cache, path_filter):
+        yield plat, Path(path)
+
+
+def discover_roms(
+    rom_root: Path,
+    max_depth: int = DEFAULT_MAX_DEPTH,
+    jobs: int = DEFAULT_SCAN_JOBS,
+    cache: Optional[DiscoveryCache] = None,
+    path_filter: Optional[PathFilter] = None,
+) -> List[Tuple[str, Path]]:
+    """
+    Discover ROMs either under <rom_root>/<platform_dir>/[...]/file
+    (where platform_dir can be exact or an alias) OR directly under
+    <rom_root> (flat), in which case we infer platform from extension when unambiguous.
+    Sorted by platform then path, so builds are reproducible.
+    """
+    found = sorted(_iter_rom_paths(rom_root, max_depth, jobs, cache, path_filter))
+    return [(plat, Path(path)) for plat, path in found]
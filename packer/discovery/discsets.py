@@ -0,0 +1,130 @@
+# packer/discovery/discsets.py
+from __future__ import annotations
+
+import os
+import posixpath
+import re
+import shlex
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+from packer.io.archive import rom_stat
+
+# Cue sheets, GD-ROM sheets and multi-disc playlists. A title with one of
+# these is the sheet plus every file it references (recursively, so an .m3u
+# pulls in each disc's .cue and that .cue's tracks); the sheet is what gets
+# launched. References must stay inside the sheet's folder.
+SHEET_EXTS = (".m3u", ".cue", ".gdi")
+SHEET_MAX_BYTES = 1 << 20
+
+_CUE_FILE = re.compile(r'^\s*FILE\s+(?:"([^"]*)"|(\S+))', re.IGNORECASE)
+
+
+def is_sheet(name: str) -> bool:
+    return name.lower().endswith(SHEET_EXTS)
+
+
+def sheet_references(path: str) -> List[str]:
+    """File names one sheet refers to, as written (relative to the sheet's folder)."""
+    with open(path, "rb") as f:
+        text = f.read(SHEET_MAX_BYTES).decode("utf-8", errors="surrogateescape")
+    ext = os.path.splitext(path)[1].lower()
+    refs: List[str] = []
+    lines = text.lstrip("\ufeff").splitlines()
+    if ext == ".cue":
+        for line in lines:
+            m = _CUE_FILE.match(line)
+            if m:
+                refs.append(m.group(1) if m.group(1) is not None else m.group(2))
+    elif ext == ".gdi":
+        # First line is the track count; then: number lba type sector_size file offset
+        for line in lines[1:]:
+            try:
+                fields = shlex.split(line)
+            except ValueError:
+                fields = line.split()
+            if len(fields) >= 6:
+                refs.append(fields[4])
+    else:
+        refs = [s for s in (line.strip() for line in lines) if s and not s.startswith("#")]
+    return refs
+
+
+def set_parts(sheet: str) -> Optional[List[str]]:
+    """
+    Every file a sheet pulls in, relative to its folder (POSIX separators),
+    in reference order and without the sheet itself. None, with a warning,
+    when the sheet can't be read or a reference is missing or escapes the
+    folder: such a title would not boot.
+    """
+    base = os.path.dirname(sheet)
+    parts: List[str] = []
+    seen = {os.path.basename(sheet)}
+    listings: Dict[str, Dict[str, str]] = {}
+    todo = [(sheet, "")]
+    while todo:
+        path, rel_dir = todo.pop(0)
+        try:
+            refs = sheet_references(path)
+        except OSError as e:
+            print(f"[discover] {os.path.basename(sheet)}: cannot read {os.path.basename(path)}: {e}")
+            return None
+        for ref in refs:
+            rel = posixpath.normpath(posixpath.join(rel_dir, ref.replace("\\", "/")))
+            if rel.startswith("../") or rel == ".." or posixpath.isabs(rel):
+                print(f"[discover] {os.path.basename(sheet)}: {ref} is outside its folder; skipped")
+                return None
+            rel = _existing(base, rel, listings)
+            if rel is None:
+                print(f"[discover] {os.path.basename(sheet)}: missing {ref}; skipped")
+                return None
+            if rel in seen:
+                continue
+            seen.add(rel)
+            parts.append(rel)
+            if is_sheet(rel):
+                todo.append((os.path.join(base, rel), posixpath.dirname(rel)))
+    return parts
+
+
+def _existing(base: str, rel: str, listings: Dict[str, Dict[str, str]]) -> Optional[str]:
+    """rel if it exists under base, else its case-insensitive match (sheets written on Windows)."""
+    if os.path.isfile(os.path.join(base, rel)):
+        return rel
+    folder, name = posixpath.split(rel)
+    if folder not in listings:
+        try:
+            listings[folder] = {n.lower(): n for n in os.listdir(os.path.join(base, folder))}
+        except OSError:
+            listings[folder] = {}
+    match = listings[folder].get(name.lower())
+    return posixpath.join(folder, match) if match else None
+
+
+def disc_set(path: Path) -> List[Tuple[Path, str]]:
+    """
+    (file, name relative to the title's folder) for every file of the title
+    at path: the file itself first, then what a sheet references. Raises
+    FileNotFoundError if a sheet's set is incomplete.
+    """
+    path = Path(path)
+    if not is_sheet(path.name) or not path.is_file():
+        return [(path, path.name)]
+    parts = set_parts(str(path))
+    if parts is None:
+        raise FileNotFoundError(f"incomplete disc set: {path}")
+    return [(path, path.name)] + [(path.parent / rel, rel) for rel in parts]
+
+
+def set_stat(path: Path) -> os.stat_result:
+    """rom_stat for a whole title: total size and newest mtime of its files."""
+    files = disc_set(path)
+    st = rom_stat(path)
+    if len(files) == 1:
+        return st
+    stats = [st] + [p.stat() for p, _ in files[1:]]
+    mtime_ns = max(s.st_mtime_ns for s in stats)
+    return os.stat_result(
+        st[:6] + (sum(s.st_size for s in stats), st[7], mtime_ns // 1_000_000_000, st[9]),
+        {"st_atime_ns": st.st_atime_ns, "st_mtime_ns": mtime_ns, "st_ctime_ns": st.st_ctime_ns},
+    )
@@ -0,0 +1,172 @@
+# packer/discovery/ignore.py
+from __future__ import annotations
+
+import os
+import re
+from typing import Iterable, List, Optional, Tuple
+
+# Per-folder exclusions, gitignore syntax: "#" comments, "!" re-includes,
+# a trailing "/" matches folders only, a "/" anywhere else anchors the
+# pattern to the file's folder, "*"/"?"/"[...]" stay within one path
+# segment and "**" spans segments. Rules apply to the folder's subtree;
+# deeper files and later lines win.
+IGNORE_FILE = ".packerignore"
+
+# One compiled rule: (regex over the path relative to the rules' folder, negated, folders only)
+_Rule = Tuple["re.Pattern[str]", bool, bool]
+
+
+def _translate(pat: str) -> str:
+    """Glob body (no leading/trailing slash handling) -> regex."""
+    out: List[str] = []
+    i, n = 0, len(pat)
+    while i < n:
+        c = pat[i]
+        if c == "*":
+            if pat.startswith("**", i):
+                at_start = i == 0 or pat[i - 1] == "/"
+                if at_start and pat.startswith("**/", i):
+                    out.append("(?:.*/)?")          # "**/": zero or more folders
+                    i += 3
+                    continue
+                if at_start and i + 2 == n:
+                    out.append(".*")                # trailing "/**": everything inside
+                    i += 2
+                    continue
+                out.append("[^/]*")
+                i += 2
+                continue
+            out.append("[^/]*")
+        elif c == "?":
+            out.append("[^/]")
+        elif c == "[":
+            j = pat.find("]", i + 2 if pat.startswith("[!", i) or pat.startswith("[^", i) else i + 1)
+            if j < 0:
+                out.append(re.escape(c))
+            else:
+                body = pat[i + 1:j]
+                if body[:1] in ("!", "^"):
+                    body = "^" + body[1:]
+                out.append("[" + body.replace("\\", "\\\\") + "]")
+                i = j
+        elif c == "\\" and i + 1 < n:
+            i += 1
+            out.append(re.escape(pat[i]))
+        else:
+            out.append(re.escape(c))
+        i += 1
+    return "".join(out)
+
+
+def compile_pattern(line: str) -> Optional[_Rule]:
+    """One gitignore line -> rule, or None for blanks and comments."""
+    if line.endswith("\n"):
+        line = line.rstrip("\r\n")
+    if not line.endswith("\\ "):
+        line = line.rstrip()
+    if not line or line.startswith("#"):
+        return None
+    negate = line.startswith("!")
+    if negate:
+        line = line[1:]
+    elif line.startswith(("\\!", "\\#")):
+        line = line[1:]
+    dir_only = line.endswith("/")
+    line = line.rstrip("/")
+    if not line:
+        return None
+    anchored = "/" in line
+    body = _translate(line.lstrip("/"))
+    return re.compile(("" if anchored else "(?:.*/)?") + body + r"\Z", re.DOTALL), negate, dir_only
+
+
+class IgnoreRules:
+    """
+    The compiled rules of one .packerignore (or of --exclude/--include),
+    for paths relative to the ROM root. base is the rules' folder relative
+    to the ROM root ("" for the root). All patterns are also joined into one
+    regex, so the common case, a path no rule mentions, is a single match.
+    """
+
+    def __init__(self, lines: Iterable[str], base: str = "") -> None:
+        self.base = base.strip("/")
+        self.rules: List[_Rule] = [r for r in (compile_pattern(l) for l in lines) if r is not None]
+        joined = "|".join(f"(?:{rx.pattern})" for rx, _, _ in self.rules)
+        self._any = re.compile(joined, re.DOTALL) if joined else None
+
+    def __bool__(self) -> bool:
+        return bool(self.rules)
+
+    def match(self, rel: str, is_dir: bool) -> Optional[bool]:
+        """True = ignored, False = re-included by a "!" rule, None = no rule applies."""
+        if self._any is None:
+            return None
+        if self.base:
+            if not rel.startswith(self.base + "/"):
+                return None
+            rel = rel[len(self.base) + 1:]
+        if not self._any.match(rel):
+            return None
+        for rx, negate, dir_only in reversed(self.rules):
+            if (is_dir or not dir_only) and rx.match(rel):
+                return not negate
+        return None
+
+
+def load_ignore_file(dir_path: str, base: str) -> Optional[IgnoreRules]:
+    try:
+        with open(os.path.join(dir_path, IGNORE_FILE), encoding="utf-8", errors="replace") as f:
+            rules = IgnoreRules(f, base)
+    except OSError as e:
+        print(f"[discover] Ignoring unreadable {os.path.join(dir_path, IGNORE_FILE)}: {e}")
+        return None
+    return rules or None
+
+
+class IgnoreChain:
+    """The .packerignore files in effect for one folder: its own, then its parents', deepest first."""
+
+    def __init__(self, rules: Optional[IgnoreRules] = None, parent: Optional["IgnoreChain"] = None) -> None:
+        self.rules = rules
+        self.parent = parent
+
+    def child(self, rules: Optional[IgnoreRules]) -> "IgnoreChain":
+        return IgnoreChain(rules, self) if rules else self
+
+    def ignored(self, rel: str, is_dir: bool) -> bool:
+        node: Optional[IgnoreChain] = self
+        while node is not None:
+            if node.rules is not None:
+                hit = node.rules.match(rel, is_dir)
+                if hit is not None:
+                    return hit
+            node = node.parent
+        return False
+
+
+class PathFilter:
+    """
+    Everything that decides which paths discovery visits: .packerignore
+    files (read as folders are listed) plus --exclude patterns, which win
+    over them, and --include patterns, which a ROM must match if any are
+    given. Folders are pruned before they are listed.
+    """
+
+    def __init__(self, exclude: Iterable[str] = (), include: Iterable[str] = ()) -> None:
+        self.exclude = IgnoreRules(exclude)
+        self.include = IgnoreRules(include)
+
+    def dir_ignored(self, chain: IgnoreChain, rel: str) -> bool:
+        hit = self.exclude.match(rel, True)
+        return hit if hit is not None else chain.ignored(rel, True)
+
+    def file_ignored(self, chain: IgnoreChain, rel: str, member_rel: Optional[str] = None) -> bool:
+        """rel is the file on disk; member_rel the ROM inside it when that is an archive member."""
+        hit = self.exclude.match(rel, False)
+        if hit is None:
+            hit = chain.ignored(rel, False)
+        if hit:
+            return True
+        if not self.include:
+            return False
+        return not (self.include.match(rel, False) or (member_rel and self.include.match(member_rel, False)))
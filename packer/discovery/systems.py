@@ -2,8 +2,11 @@
 from __future__ import annotations
 
 import json
+import os
+import struct
+from dataclasses import dataclass
 from pathlib import Path
-from typing import Dict, Iterable, Optional
+from typing import BinaryIO, Callable, Dict, Iterable, List, Optional
 
 # ---- 1) Baseline platform -> extensions mapping ----
 _DEFAULT_PLATFORM_EXTS: Dict[str, Iterable[str]] = {
@@ -13,6 +16,11 @@ _DEFAULT_PLATFORM_EXTS: Dict[str, Iterable[str]] = {
     "Nintendo - Game Boy Advance": (".gba",),
     "Nintendo - Game Boy": (".gb",),
     "Nintendo - Game Boy Color": (".gbc",),
+    # Disc systems: tracks (.bin/.iso/.raw) come with their sheet (see discsets.py)
+    "Sony - PlayStation": (".cue", ".m3u", ".chd", ".pbp"),
+    "Sega - Saturn": (".cue", ".m3u", ".chd"),
+    "Sega - Mega-CD - Sega CD": (".cue", ".m3u", ".chd"),
+    "Sega - Dreamcast": (".gdi", ".cdi", ".cue", ".m3u", ".chd"),
 }
 
 # ---- 2) Config file paths ----
@@ -49,7 +57,158 @@ for plat, exts in PLATFORM_EXTS.items():
     for ext in exts:
         EXT_TO_PLAT.setdefault(ext.lower(), set()).add(plat)
 
-# ---- 4) Aliases (case-insensitive) ----
+# Generic dump extensions: a flat file with one of these needs a matching
+# header even when a single platform claims the extension, so a stray disc
+# track or an Atari 2600 .bin is never listed as a Genesis ROM.
+GENERIC_EXTS = frozenset({".bin"})
+
+
+def is_ambiguous_ext(ext: str) -> bool:
+    """Whether a flat file's platform must come from its header (see sniff_platform)."""
+    ext = ext.lower()
+    return len(EXT_TO_PLAT.get(ext, ())) > 1 or (ext in GENERIC_EXTS and ext in EXT_TO_PLAT)
+
+# ---- 4) Header signatures (content sniffing for ambiguous extensions) ----
+# Each probe gets read(offset, length) -> bytes (positioned reads; short at
+# EOF) and the file size, and must only look at small windows: it runs during
+# discovery. Extend with register_signature(), e.g. from a plugin.
+HeaderRead = Callable[[int, int], bytes]
+HeaderProbe = Callable[[HeaderRead, int], bool]
+
+
+@dataclass(frozen=True)
+class HeaderSignature:
+    platform: str
+    probe: HeaderProbe
+
+
+def magic_at(offset: int, magic: bytes) -> HeaderProbe:
+    return lambda read, size: read(offset, len(magic)) == magic
+
+
+_GB_LOGO = bytes.fromhex(
+    "CEED6666CC0D000B03730083000C000D0008111F8889000E"
+    "DCCC6EE6DDDDD999BBBB67636E0EECCCDDDC999FBBB9333E"
+)
+_GBA_LOGO_HEAD = bytes.fromhex("24FFAE51699AA2213D84820A84E409AD")
+
+
+def _gb_cgb_flag(read: HeaderRead) -> Optional[int]:
+    if read(0x104, len(_GB_LOGO)) != _GB_LOGO:
+        return None
+    flag = read(0x143, 1)
+    return flag[0] if flag else 0
+
+
+def _is_gb(read: HeaderRead, size: int) -> bool:
+    flag = _gb_cgb_flag(read)
+    return flag is not None and flag not in (0x80, 0xC0)
+
+
+def _is_gbc(read: HeaderRead, size: int) -> bool:
+    # 0x80 = dual-mode, 0xC0 = GBC only; No-Intro files both under GBC.
+    return _gb_cgb_flag(read) in (0x80, 0xC0)
+
+
+def _is_gba(read: HeaderRead, size: int) -> bool:
+    return read(0x04, len(_GBA_LOGO_HEAD)) == _GBA_LOGO_HEAD and read(0xB2, 1) == b"\x96"
+
+
+def _is_genesis(read: HeaderRead, size: int) -> bool:
+    # "SEGA MEGA DRIVE", "SEGA GENESIS"; a few carts pad it with a leading space
+    console = read(0x100, 16)
+    return console.lstrip(b" ").startswith(b"SEGA") and b"32X" not in console
+
+
+def _is_snes(read: HeaderRead, size: int) -> bool:
+    # Internal header at LoROM 0x7FC0 / HiROM 0xFFC0 (+0x200 with a copier
+    # header): checksum complement (0x1C) XOR checksum (0x1E) == 0xFFFF.
+    copier = 0x200 if size % 0x400 == 0x200 else 0
+    for base in (0x7FC0, 0xFFC0):
+        raw = read(copier + base + 0x1C, 4)
+        if len(raw) == 4:
+            complement, checksum = struct.unpack("<HH", raw)
+            if complement ^ checksum == 0xFFFF and checksum not in (0x0000, 0xFFFF):
+                return True
+    return False
+
+
+HEADER_SIGNATURES: List[HeaderSignature] = [
+    HeaderSignature("Nintendo - Nintendo Entertainment System", magic_at(0, b"NES\x1a")),
+    HeaderSignature("Nintendo - Game Boy Advance", _is_gba),
+    HeaderSignature("Nintendo - Game Boy Color", _is_gbc),
+    HeaderSignature("Nintendo - Game Boy", _is_gb),
+    HeaderSignature("Sega - Mega Drive - Genesis", _is_genesis),
+    HeaderSignature("Nintendo - Super Nintendo Entertainment System", _is_snes),
+]
+
+
+def register_signature(platform: str, probe: HeaderProbe, first: bool = False) -> None:
+    sig = HeaderSignature(platform, probe)
+    if first:
+        HEADER_SIGNATURES.insert(0, sig)
+    else:
+        HEADER_SIGNATURES.append(sig)
+
+
+def sniff_platform(path: Path, candidates: Iterable[str]) -> Optional[str]:
+    """
+    Identify a ROM among candidate platforms from its header. Only the windows
+    the probes ask for are read (os.pread), never the whole file. Returns the
+    first matching candidate in HEADER_SIGNATURES order, or None.
+    """
+    sigs = _signatures_for(candidates)
+    if not sigs:
+        return None
+    try:
+        fd = os.open(path, os.O_RDONLY | getattr(os, "O_BINARY", 0))
+    except OSError:
+        return None
+    try:
+        size = os.fstat(fd).st_size
+
+        def read(offset: int, length: int) -> bytes:
+            if offset >= size:
+                return b""
+            if hasattr(os, "pread"):
+                return os.pread(fd, length, offset)
+            os.lseek(fd, offset, os.SEEK_SET)       # Windows: no pread
+            return os.read(fd, length)
+
+        return _probe(sigs, read, size)
+    finally:
+        os.close(fd)
+
+
+def sniff_stream(f: BinaryIO, size: int, candidates: Iterable[str]) -> Optional[str]:
+    """sniff_platform for an open, seekable stream of size bytes (e.g. a zip member from open_rom)."""
+    sigs = _signatures_for(candidates)
+
+    def read(offset: int, length: int) -> bytes:
+        if offset >= size:
+            return b""
+        f.seek(offset)
+        return f.read(length)
+
+    return _probe(sigs, read, size)
+
+
+def _signatures_for(candidates: Iterable[str]) -> List[HeaderSignature]:
+    wanted = set(candidates)
+    return [s for s in HEADER_SIGNATURES if s.platform in wanted]
+
+
+def _probe(sigs: List[HeaderSignature], read: HeaderRead, size: int) -> Optional[str]:
+    for sig in sigs:
+        try:
+            if sig.probe(read, size):
+                return sig.platform
+        except OSError:
+            return None
+    return None
+
+
+# ---- 5) Aliases (case-insensitive) ----
 # Built-ins, can be extended via config/systems_aliases.json
 _DEFAULT_ALIASES = {
     "snes": "Nintendo - Super Nintendo Entertainment System",
@@ -70,6 +229,20 @@ _DEFAULT_ALIASES = {
 
     "gbc": "Nintendo - Game Boy Color",
     "game boy color": "Nintendo - Game Boy Color",
+
+    "psx": "Sony - PlayStation",
+    "ps1": "Sony - PlayStation",
+    "playstation": "Sony - PlayStation",
+
+    "saturn": "Sega - Saturn",
+
+    "segacd": "Sega - Mega-CD - Sega CD",
+    "sega cd": "Sega - Mega-CD - Sega CD",
+    "megacd": "Sega - Mega-CD - Sega CD",
+    "mega cd": "Sega - Mega-CD - Sega CD",
+
+    "dreamcast": "Sega - Dreamcast",
+    "dc": "Sega - Dreamcast",
 }
 
 _alias_overrides = _load_json_dict(_ALIASES_JSON)
@@ -60,6 +60,24 @@ def icon_provider_search(
 
 
 
+def _subdirs_for(preference: str) -> List[str]:
+    if preference == "boxarts":
+        return ["Named_Boxarts", "Named_Logos", "Named_Titles", "Named_Snaps"]
+    return ["Named_Logos", "Named_Boxarts", "Named_Titles", "Named_Snaps"]
+
+
+def find_icon_exact(platform: str, thumbnail_name: str, *, preference: str = "logos") -> Optional[Path]:
+    """Icon for a known libretro thumbnail name (DAT match); None if the pack has none."""
+    try:
+        p = libretro.fetch_named_icon(platform, thumbnail_name, subdirs=_subdirs_for(preference))
+    except Exception as e:
+        print(f"[icons] libretro provider failed for {thumbnail_name}: {e}")
+        return None
+    if p:
+        print(f"[icons] using ICON file: {p}")
+    return p
+
+
 def find_icon_with_alts(
     platform: str,
     primary_title: str,
@@ -77,10 +95,7 @@ def find_icon_with_alts(
         - "logos"   -> ["Named_Logos", "Named_Boxarts", "Named_Titles", "Named_Snaps"]
         - "boxarts" -> ["Named_Boxarts", "Named_Logos", "Named_Titles", "Named_Snaps"]
     """
-    if preference == "boxarts":
-        subdirs = ["Named_Boxarts", "Named_Logos", "Named_Titles", "Named_Snaps"]
-    else:
-        subdirs = ["Named_Logos", "Named_Boxarts", "Named_Titles", "Named_Snaps"]
+    subdirs = _subdirs_for(preference)
 
     candidates = [primary_title] + [
         t for t in alt_titles if t.lower() != primary_title.lower()
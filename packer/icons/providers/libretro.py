@@ -4,7 +4,7 @@ import re
 import unicodedata
 from pathlib import Path
 from typing import Optional, List, Tuple
-from urllib.parse import unquote
+from urllib.parse import quote, unquote
 
 import requests
 
@@ -301,6 +301,30 @@ def _try_exact_variants(platform_url: str, subdir: str, title: str, preferred_la
     return None
 
 
+def fetch_named_icon(
+    platform: str,
+    thumbnail_name: str,
+    *,
+    subdirs: Optional[list[str]] = None,
+    normalize_method: str = "letterbox",
+    bg=(0, 0, 0),
+) -> Optional[Path]:
+    """
+    Fetch the thumbnail with this exact libretro name (e.g. from a DAT match):
+    one direct request per subdir, no listings and no fuzzy scoring.
+    """
+    cache_jpg = _icon_cache_path(platform, thumbnail_name)
+    if cache_jpg.exists():
+        return cache_jpg
+    platform_url = _platform_url(platform)
+    for subdir in subdirs if subdirs is not None else _SUBDIRS:
+        data = _download_bytes(f"{_BASE_URL}/{platform_url}/{subdir}/{quote(thumbnail_name)}.png")
+        if data and _png_bytes_to_jpeg_file(data, cache_jpg, normalize_method=normalize_method, bg=bg):
+            print(f"[icons] exact icon hit in {subdir} for '{thumbnail_name}'")
+            return cache_jpg
+    return None
+
+
 def search_icon(
     platform: str,
     title: str,
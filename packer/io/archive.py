@@ -0,0 +1,111 @@
+# packer/io/archive.py
+from __future__ import annotations
+
+import os
+import shutil
+import zipfile
+from pathlib import Path
+from typing import BinaryIO, Callable, Optional, Tuple
+
+# Archives searched for a ROM during discovery. A ROM inside one is addressed
+# by a member path, "<archive>/<member name>", e.g. roms/snes/Foo.zip/Foo.sfc;
+# the helpers below accept those and plain file paths alike.
+ARCHIVE_EXTS = (".zip",)
+COPY_BUFSIZE = 8 << 20
+
+
+def is_archive_name(name: str) -> bool:
+    return name.lower().endswith(ARCHIVE_EXTS)
+
+
+def pick_member(archive: str, accept: Callable[[str], bool]) -> Optional[str]:
+    """
+    First member (in central-directory order) whose name accept()s, or None.
+    Only the central directory is read, never member data. Archives holding
+    several ROMs contribute the first one.
+    """
+    try:
+        with zipfile.ZipFile(archive) as zf:
+            for info in zf.infolist():
+                if not info.is_dir() and accept(info.filename):
+                    return info.filename
+    except (OSError, zipfile.BadZipFile) as e:
+        print(f"[discover] Skipping unreadable archive {os.path.basename(archive)}: {e}")
+    return None
+
+
+def split_member(path: Path) -> Optional[Tuple[Path, str]]:
+    """(archive, member name) for a member path; None for a plain file."""
+    parts = Path(path).parts
+    for i in range(len(parts) - 1, 0, -1):
+        if is_archive_name(parts[i - 1]):
+            archive = Path(*parts[:i])
+            if archive.is_file():
+                return archive, "/".join(parts[i:])
+    return None
+
+
+def real_path(path: Path) -> Path:
+    """The file on disk backing path: the archive for a member path."""
+    split = split_member(path)
+    return split[0] if split else Path(path)
+
+
+def rom_stat(path: Path) -> os.stat_result:
+    """
+    stat() for plain files; for members, the archive's stat (identity and
+    mtime change with any rewrite) with st_size the member's uncompressed size.
+    """
+    split = split_member(path)
+    if split is None:
+        return Path(path).stat()
+    archive, member = split
+    st = archive.stat()
+    with _open_zip(archive) as zf:
+        size = _info(zf, member).file_size
+    return os.stat_result(
+        st[:6] + (size,) + st[7:10],
+        {"st_atime_ns": st.st_atime_ns, "st_mtime_ns": st.st_mtime_ns, "st_ctime_ns": st.st_ctime_ns},
+    )
+
+
+def open_rom(path: Path) -> BinaryIO:
+    """Binary stream of a ROM; members are decompressed on the fly, never extracted."""
+    split = split_member(path)
+    if split is None:
+        return Path(path).open("rb", buffering=0)
+    archive, member = split
+    zf = _open_zip(archive)
+    try:
+        f = zf.open(_info(zf, member))
+    except BaseException:
+        zf.close()
+        raise
+    # The member stream keeps its own handle on the archive file.
+    zf.close()
+    return f
+
+
+def copy_rom(src: Path, dst: Path) -> None:
+    """Copy a ROM (or stream an archive member) to dst, keeping the source mtime."""
+    if split_member(src) is None:
+        shutil.copy2(src, dst)
+        return
+    with open_rom(src) as fi, Path(dst).open("wb") as fo:
+        shutil.copyfileobj(fi, fo, COPY_BUFSIZE)
+    shutil.copystat(real_path(src), dst)
+
+
+def _open_zip(archive: Path) -> zipfile.ZipFile:
+    # A damaged archive is an unreadable file to callers, like any other I/O error.
+    try:
+        return zipfile.ZipFile(archive)
+    except zipfile.BadZipFile as e:
+        raise OSError(f"{archive}: {e}") from None
+
+
+def _info(zf: zipfile.ZipFile, member: str) -> zipfile.ZipInfo:
+    try:
+        return zf.getinfo(member)
+    except KeyError:
+        raise FileNotFoundError(f"{member} not found in {zf.filename}") from None
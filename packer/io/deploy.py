@@ -0,0 +1,256 @@
+# packer/io/deploy.py
+from __future__ import annotations
+
+import hashlib
+import json
+import os
+import posixpath
+import shutil
+from concurrent.futures import ThreadPoolExecutor, as_completed
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Dict, Iterable, List, Optional, Tuple
+
+from packer.discovery.discsets import disc_set
+
+from .archive import open_rom, real_path, rom_stat
+from .fsutil import atomic_write_text
+
+# Deploy manifest, kept on the target so any machine can deploy incrementally.
+DEPLOY_MANIFEST = "switch-rom-packer/deploy.json"
+DEPLOY_VERSION = 1
+
+# Default target layout (relative to the SD/install root).
+NRO_DEST = "switch/switch-rom-packer"
+NSP_DEST = "switch-rom-packer/nsp"
+ROM_DEST = "roms"
+PLAYLIST_DEST = "retroarch/playlists"
+
+COPY_BUFSIZE = 8 << 20
+TMP_SUFFIX = ".deploy-tmp"
+
+
+@dataclass
+class DeployItem:
+    src: Path
+    dest: str            # POSIX path relative to the target root
+
+
+@dataclass
+class DeployStats:
+    copied: int = 0
+    unchanged: int = 0
+    deleted: int = 0
+    bytes_copied: int = 0
+    failed: int = 0
+
+
+def plan_outputs(out_dir: Path) -> List[DeployItem]:
+    """NROs, NSPs and RetroArch playlists produced by the packer under <out_dir>."""
+    items: List[DeployItem] = []
+    for sub, dest, pattern in (
+        ("nro", NRO_DEST, "*.nro"),
+        ("nsp", NSP_DEST, "*.nsp"),
+        ("playlists", PLAYLIST_DEST, "*.lpl"),
+    ):
+        base = out_dir / sub
+        if base.is_dir():
+            for p in sorted(base.rglob(pattern)):
+                if p.is_file():
+                    items.append(DeployItem(p, f"{dest}/{p.relative_to(base).as_posix()}"))
+    return items
+
+
+def rom_sd_name(rom_root: Path, rom_path: Path) -> str:
+    """
+    Path of a ROM below /roms/<platform>/ on the target: its folders below the
+    platform folder plus its name, so same-named ROMs in different subfolders
+    stay apart. An archive member keeps its archive's folder but lands as the
+    bare ROM; files directly in rom_root go straight into the platform folder.
+    """
+    try:
+        parts = real_path(rom_path).relative_to(rom_root).parts
+    except ValueError:
+        return rom_path.name
+    return "/".join(parts[1:-1] + (rom_path.name,))
+
+
+def check_destinations(dests: Iterable[Tuple[str, Path]], tag: str = "packer") -> None:
+    """
+    Refuse (SystemExit) when two different files map to the same target path.
+    SD cards are FAT32/exFAT, so names differing only in case collide too.
+    """
+    seen: Dict[str, Tuple[str, Path]] = {}
+    clashes: List[str] = []
+    for dest, src in dests:
+        first = seen.setdefault(dest.casefold(), (dest, src))
+        if first[1] != src:
+            clashes.append(f"  /{first[0]}: {first[1]}\n  /{dest}: {src}")
+    if clashes:
+        raise SystemExit(
+            f"[{tag}] These files would overwrite each other on the SD card; rename or move one of each:\n"
+            + "\n".join(clashes)
+        )
+
+
+def plan_roms(roms: Iterable[Tuple[str, Path]], rom_root: Path) -> List[DeployItem]:
+    """
+    ROMs at /roms/<platform>/<rom_sd_name>, where the stub and the forwarders
+    expect them. Archive members are deployed as the bare ROM; a disc set
+    brings all of its files, laid out as next to its sheet.
+    """
+    items: List[DeployItem] = []
+    for platform, p in roms:
+        try:
+            files = disc_set(Path(p))
+        except OSError as e:
+            print(f"[deploy] Skipping {p}: {e}")
+            continue
+        base = f"{ROM_DEST}/{platform}/{posixpath.dirname(rom_sd_name(rom_root, Path(p)))}".rstrip("/")
+        items += [DeployItem(f, f"{base}/{rel}") for f, rel in files]
+    return items
+
+
+def _hash_file(path: Path) -> str:
+    h = hashlib.blake2b(digest_size=16)
+    with open_rom(path) as f:
+        while True:
+            chunk = f.read(COPY_BUFSIZE)
+            if not chunk:
+                break
+            h.update(chunk)
+    return h.hexdigest()
+
+
+def _copy_atomic(src: Path, dst: Path) -> str:
+    """Copy with a large buffer into <dst>.deploy-tmp, then rename over dst. Returns the content hash."""
+    dst.parent.mkdir(parents=True, exist_ok=True)
+    tmp = dst.with_name(dst.name + TMP_SUFFIX)
+    h = hashlib.blake2b(digest_size=16)
+    buf = bytearray(COPY_BUFSIZE)
+    view = memoryview(buf)
+    try:
+        with open_rom(src) as fi, tmp.open("wb", buffering=0) as fo:
+            while True:
+                n = fi.readinto(buf)
+                if not n:
+                    break
+                h.update(view[:n])
+                fo.write(view[:n])
+            fo.flush()
+            os.fsync(fo.fileno())
+        os.replace(tmp, dst)
+    finally:
+        if tmp.exists():
+            tmp.unlink()
+    shutil.copystat(real_path(src), dst, follow_symlinks=True)
+    return h.hexdigest()
+
+
+def _load_manifest(path: Path) -> Dict[str, dict]:
+    try:
+        data = json.loads(path.read_text(encoding="utf-8"))
+    except FileNotFoundError:
+        return {}
+    except (OSError, ValueError) as e:
+        print(f"[deploy] Ignoring unreadable manifest {path}: {e}")
+        return {}
+    if not isinstance(data, dict) or data.get("version") != DEPLOY_VERSION:
+        return {}
+    files = data.get("files")
+    return files if isinstance(files, dict) else {}
+
+
+def _save_manifest(path: Path, files: Dict[str, dict]) -> None:
+    doc = {"version": DEPLOY_VERSION, "files": dict(sorted(files.items()))}
+    atomic_write_text(path, json.dumps(doc, indent=1))
+
+
+def _needs_copy(item: DeployItem, target: Path, prev: Optional[dict]) -> Tuple[bool, Optional[str]]:
+    """
+    (copy?, known hash). Unchanged size+mtime with the target still present is
+    trusted without reading anything; otherwise the source is hashed and only
+    copied if its content differs from what was deployed.
+    """
+    st = rom_stat(item.src)
+    dst = target / item.dest
+    try:
+        dst_size = dst.stat().st_size
+    except FileNotFoundError:
+        return True, None
+    if not prev or prev.get("size") != st.st_size or dst_size != st.st_size:
+        return True, None
+    if prev.get("mtime_ns") == st.st_mtime_ns:
+        return False, prev.get("hash")
+    digest = _hash_file(item.src)
+    return digest != prev.get("hash"), digest
+
+
+def deploy(
+    items: List[DeployItem],
+    target: Path,
+    *,
+    jobs: int = 4,
+    delete_orphans: bool = True,
+    orphan_scope: Optional[Iterable[str]] = None,
+    dry_run: bool = False,
+) -> DeployStats:
+    """
+    Copy new or changed items to target, delete files from earlier deploys that
+    are no longer produced, and record what is deployed in DEPLOY_MANIFEST.
+    Files the packer never deployed are never touched. orphan_scope limits
+    deletion to these destination prefixes (e.g. leave ROMs alone when this run
+    did not plan any).
+    """
+    scope = tuple(p.rstrip("/") + "/" for p in orphan_scope) if orphan_scope is not None else ("",)
+    target = Path(target)
+    manifest_path = target / DEPLOY_MANIFEST
+    previous = _load_manifest(manifest_path)
+    current: Dict[str, dict] = {}
+    stats = DeployStats()
+
+    # Two sources for one path would leave whichever copied last; refuse before touching the target
+    items = list(items)
+    check_destinations(((item.dest, item.src) for item in items), "deploy")
+    by_dest = {item.dest: item for item in items}
+
+    def _one(item: DeployItem) -> Tuple[DeployItem, bool, Optional[str]]:
+        copy, digest = _needs_copy(item, target, previous.get(item.dest))
+        if copy and not dry_run:
+            digest = _copy_atomic(item.src, target / item.dest)
+        return item, copy, digest
+
+    with ThreadPoolExecutor(max_workers=max(1, jobs)) as pool:
+        futures = [pool.submit(_one, it) for it in by_dest.values()]
+        for fut in as_completed(futures):
+            try:
+                item, copied, digest = fut.result()
+            except OSError as e:
+                stats.failed += 1
+                print(f"[deploy] ERROR: {e}")
+                continue
+            st = rom_stat(item.src)
+            if copied:
+                stats.copied += 1
+                stats.bytes_copied += st.st_size
+                print(f"[deploy] {'would copy' if dry_run else 'copied'} {item.dest}")
+            else:
+                stats.unchanged += 1
+            current[item.dest] = {"size": st.st_size, "mtime_ns": st.st_mtime_ns, "hash": digest}
+
+    # Keep entries for failed items so a later run can still clean them up.
+    for dest, entry in previous.items():
+        if dest not in by_dest:
+            if delete_orphans and dest.startswith(scope):
+                if not dry_run:
+                    (target / dest).unlink(missing_ok=True)
+                stats.deleted += 1
+                print(f"[deploy] {'would delete' if dry_run else 'deleted'} {dest}")
+            else:
+                current[dest] = entry
+        elif dest not in current:
+            current[dest] = entry
+
+    if not dry_run:
+        _save_manifest(manifest_path, current)
+    return stats
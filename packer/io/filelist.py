@@ -1,19 +1,248 @@
 from __future__ import annotations
 
+import posixpath
+import struct
+import zlib
+from dataclasses import dataclass
 from pathlib import Path
-from typing import Iterable, Tuple
+from typing import Iterable, List, Optional, Tuple
 
-from .fsutil import atomic_write_text
+from .fsutil import atomic_write_bytes, atomic_write_text
 
 
 def write_filelist(filelist_path: Path, entries: Iterable[Tuple[str, str]]) -> None:
     """
-    Write lines of the form '<platform> <filename>' expected by the stub.
-    
+    Write lines of the form '<platform> <path below /roms/<platform>/>', a
+    human-readable summary of a build (the stub reads manifest.bin instead).
+
     Args:
         filelist_path: destination file path
-        entries: iterable of (platform, filename) pairs
+        entries: iterable of (platform, path) pairs
     """
     lines = (f"{plat} {fname}\n" for plat, fname in entries)
     atomic_write_text(filelist_path, "".join(lines))
     print(f"[packer] Wrote {len(list(entries))} entries to {filelist_path}")
+
+
+# ---------- Binary extraction manifest (romfs:/manifest.bin) ----------
+#
+# Little-endian, read by the stub in a single fread. Layout:
+#
+#   header  (MANIFEST_HEADER_SIZE bytes)
+#     char[4] magic "SRPM"
+#     u16     version
+#     u16     header_size
+#     u32     entry_count
+#     u32     entry_size
+#     u32     entries_offset
+#     u32     strtab_offset
+#     u32     strtab_size
+#     u32     flags            (reserved, 0)
+#     u32     dir_count        (v2+) number of directories to pre-create
+#     u32     dirs_offset      (v2+) u32[dir_count] strtab offsets, parents first
+#
+#   entries (entry_count * entry_size bytes, fixed layout)
+#     u64     size             uncompressed payload size in bytes
+#     u32     crc32            zlib-compatible CRC32 of the payload
+#     u16     codec            MANIFEST_CODEC_*
+#     u16     flags            MANIFEST_ENTRY_*
+#     u32     src_off          RomFS-relative source path (strtab offset)
+#     u32     platform_off     platform folder name (strtab offset)
+#     u32     dest_off         absolute SD destination, or MANIFEST_NO_STRING
+#     u32[5]  reserved
+#
+#   dirs    (dir_count * u32, v2+) every unique destination directory, so the
+#           stub creates each one once per run instead of mkdir -p per file
+#
+#   strtab  (strtab_size bytes of NUL-terminated UTF-8 strings)
+#
+# Keep in sync with stub/include/manifest.h.
+
+MANIFEST_NAME = "manifest.bin"
+MANIFEST_MAGIC = b"SRPM"
+MANIFEST_VERSION = 2
+
+# Mirrors EXTRACT_OUTPUT_BASE in stub/include/extract.h.
+MANIFEST_OUTPUT_BASE = "/roms/"
+
+MANIFEST_CODEC_NONE = 0
+
+MANIFEST_ENTRY_VERIFY_CRC = 0x0001
+
+MANIFEST_NO_STRING = 0xFFFFFFFF
+
+_HEADER_V1 = struct.Struct("<4sHHIIIIII")
+_HEADER = struct.Struct("<4sHHIIIIIIII")
+_ENTRY = struct.Struct("<QIHHIII20x")
+
+MANIFEST_HEADER_SIZE = _HEADER.size
+MANIFEST_ENTRY_SIZE = _ENTRY.size
+
+
+@dataclass
+class ManifestEntry:
+    platform: str
+    src: str                      # path relative to romfs:/
+    size: int
+    crc32: int
+    codec: int = MANIFEST_CODEC_NONE
+    flags: int = MANIFEST_ENTRY_VERIFY_CRC
+    dest: Optional[str] = None    # absolute SD path; None -> /roms/<platform>/<basename(src)>
+
+
+class _StringTable:
+    """Deduplicating NUL-terminated string table."""
+
+    def __init__(self) -> None:
+        self._buf = bytearray()
+        self._offsets: dict[str, int] = {}
+
+    def add(self, s: Optional[str]) -> int:
+        if s is None:
+            return MANIFEST_NO_STRING
+        off = self._offsets.get(s)
+        if off is None:
+            off = len(self._buf)
+            self._buf += s.encode("utf-8") + b"\0"
+            self._offsets[s] = off
+        return off
+
+    def bytes(self) -> bytes:
+        return bytes(self._buf)
+
+
+def file_crc32(path: Path, bufsize: int = 1 << 20) -> Tuple[int, int]:
+    """Stream a file once and return (size, crc32)."""
+    crc = 0
+    size = 0
+    with Path(path).open("rb") as f:
+        while True:
+            chunk = f.read(bufsize)
+            if not chunk:
+                break
+            crc = zlib.crc32(chunk, crc)
+            size += len(chunk)
+    return size, crc & 0xFFFFFFFF
+
+
+def manifest_entry_for_file(platform: str, path: Path, src: Optional[str] = None) -> ManifestEntry:
+    """Build a manifest entry for a file that will be embedded at romfs:/<src>."""
+    size, crc = file_crc32(path)
+    return ManifestEntry(platform=platform, src=src or Path(path).name, size=size, crc32=crc)
+
+
+def manifest_destination(e: ManifestEntry) -> str:
+    """SD path the stub extracts an entry to."""
+    if e.dest:
+        return e.dest
+    return f"{MANIFEST_OUTPUT_BASE}{e.platform}/{posixpath.basename(e.src)}"
+
+
+def manifest_directories(entries: Iterable[ManifestEntry]) -> List[str]:
+    """Every unique destination directory (including prefixes), parents first."""
+    dirs: set[str] = set()
+    for e in entries:
+        d = posixpath.dirname(manifest_destination(e))
+        while d and d not in ("/", ".") and d not in dirs:
+            dirs.add(d)
+            d = posixpath.dirname(d)
+    return sorted(dirs, key=lambda d: (d.count("/"), d))
+
+
+def encode_manifest(entries: Iterable[ManifestEntry]) -> bytes:
+    entries = list(entries)
+    strtab = _StringTable()
+    packed: List[bytes] = []
+    for e in entries:
+        if "\0" in e.src or "\0" in e.platform or (e.dest and "\0" in e.dest):
+            raise ValueError(f"NUL byte in manifest string for {e.src!r}")
+        packed.append(_ENTRY.pack(
+            e.size,
+            e.crc32 & 0xFFFFFFFF,
+            e.codec,
+            e.flags,
+            strtab.add(e.src),
+            strtab.add(e.platform),
+            strtab.add(e.dest),
+        ))
+
+    dirs = manifest_directories(entries)
+    dir_offsets = [strtab.add(d) for d in dirs]
+
+    entries_offset = MANIFEST_HEADER_SIZE
+    dirs_offset = entries_offset + MANIFEST_ENTRY_SIZE * len(packed)
+    strtab_offset = dirs_offset + 4 * len(dir_offsets)
+    strtab_bytes = strtab.bytes()
+    header = _HEADER.pack(
+        MANIFEST_MAGIC,
+        MANIFEST_VERSION,
+        MANIFEST_HEADER_SIZE,
+        len(packed),
+        MANIFEST_ENTRY_SIZE,
+        entries_offset,
+        strtab_offset,
+        len(strtab_bytes),
+        0,
+        len(dir_offsets),
+        dirs_offset,
+    )
+    dir_table = struct.pack(f"<{len(dir_offsets)}I", *dir_offsets)
+    return header + b"".join(packed) + dir_table + strtab_bytes
+
+
+def decode_manifest(data: bytes) -> List[ManifestEntry]:
+    """Inverse of encode_manifest (used for inspection and tests)."""
+    return _decode(data)[0]
+
+
+def decode_manifest_dirs(data: bytes) -> List[str]:
+    """Directory list of a v2+ manifest (empty for v1)."""
+    return _decode(data)[1]
+
+
+def _decode(data: bytes) -> Tuple[List[ManifestEntry], List[str]]:
+    if len(data) < _HEADER_V1.size:
+        raise ValueError("manifest too short")
+    (magic, version, header_size, count, entry_size,
+     entries_offset, strtab_offset, strtab_size, _flags) = _HEADER_V1.unpack_from(data, 0)
+    if magic != MANIFEST_MAGIC:
+        raise ValueError(f"bad manifest magic {magic!r}")
+    if version > MANIFEST_VERSION:
+        raise ValueError(f"unsupported manifest version {version}")
+    if entry_size < MANIFEST_ENTRY_SIZE or strtab_offset + strtab_size > len(data):
+        raise ValueError("manifest layout out of bounds")
+    dir_count, dirs_offset = 0, 0
+    if version >= 2 and header_size >= _HEADER.size:
+        dir_count, dirs_offset = struct.unpack_from("<II", data, _HEADER_V1.size)
+
+    strtab = data[strtab_offset:strtab_offset + strtab_size]
+
+    def _str(off: int) -> Optional[str]:
+        if off == MANIFEST_NO_STRING:
+            return None
+        end = strtab.index(b"\0", off)
+        return strtab[off:end].decode("utf-8")
+
+    dirs = [_str(off) or "" for off in struct.unpack_from(f"<{dir_count}I", data, dirs_offset)]
+
+    out: List[ManifestEntry] = []
+    for i in range(count):
+        size, crc, codec, flags, src_off, plat_off, dest_off = _ENTRY.unpack_from(
+            data, entries_offset + i * entry_size
+        )
+        out.append(ManifestEntry(
+            platform=_str(plat_off) or "",
+            src=_str(src_off) or "",
+            size=size,
+            crc32=crc,
+            codec=codec,
+            flags=flags,
+            dest=_str(dest_off),
+        ))
+    return out, dirs
+
+
+def write_manifest(manifest_path: Path, entries: Iterable[ManifestEntry]) -> None:
+    """Write the binary extraction manifest consumed by the stub."""
+    entries = list(entries)
+    atomic_write_bytes(manifest_path, encode_manifest(entries))
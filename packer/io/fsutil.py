@@ -44,6 +44,23 @@ def atomic_write_text(path: Path, text: str, encoding: str = "utf-8") -> None:
             pass
 
 
+def atomic_write_bytes(path: Path, data: bytes) -> None:
+    """Binary counterpart of atomic_write_text."""
+    path = Path(path)
+    ensure_dir(path.parent)
+    fd, tmp = tempfile.mkstemp(prefix=path.name + ".", dir=str(path.parent))
+    try:
+        with os.fdopen(fd, "wb") as f:
+            f.write(data)
+        Path(tmp).replace(path)
+    finally:
+        try:
+            if Path(tmp).exists():
+                Path(tmp).unlink()
+        except Exception:
+            pass
+
+
 def copy_into(src: Path, dst_dir: Path) -> Path:
     """
     Copy a file into a directory (creating the directory if needed).
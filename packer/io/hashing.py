@@ -0,0 +1,204 @@
+# packer/io/hashing.py
+from __future__ import annotations
+
+import hashlib
+import os
+import sqlite3
+import zlib
+from concurrent.futures import ThreadPoolExecutor, as_completed
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Dict, Iterable, Optional
+
+from .archive import open_rom, rom_stat
+
+# xxh3 when the optional xxhash package is installed, else 8-byte BLAKE2b.
+# The algorithm is part of the cache key so switching never mixes values.
+try:
+    import xxhash  # type: ignore
+    FAST_HASH_NAME = "xxh3_64"
+    _new_fast = xxhash.xxh3_64
+except Exception:
+    xxhash = None
+    FAST_HASH_NAME = "blake2b_64"
+    _new_fast = lambda: hashlib.blake2b(digest_size=8)  # noqa: E731
+
+# Cache root: ~/.switch-rom-packer/cache/hashes.sqlite
+DEFAULT_HASH_CACHE = Path.home() / ".switch-rom-packer" / "cache" / "hashes.sqlite"
+HASH_BUFSIZE = 8 << 20
+DEFAULT_HASH_JOBS = 4
+COMMIT_EVERY = 256
+
+
+@dataclass(frozen=True)
+class FileHashes:
+    size: int
+    crc32: int
+    sha1: str
+    fast64: str         # FAST_HASH_NAME, hex
+
+
+def hash_file(path: Path, bufsize: int = HASH_BUFSIZE, size_hint: Optional[int] = None) -> FileHashes:
+    """
+    CRC32, SHA1 and the fast hash in one streaming pass over a reused buffer.
+    Archive members are hashed as they decompress.
+    """
+    crc = 0
+    size = 0
+    sha1 = hashlib.sha1()
+    fast = _new_fast()
+    if size_hint is None:
+        size_hint = rom_stat(path).st_size
+    with open_rom(path) as f:
+        # Small ROMs don't need (or pay for zeroing) the full buffer.
+        buf = bytearray(min(bufsize, max(size_hint, 1 << 16)))
+        view = memoryview(buf)
+        while True:
+            n = f.readinto(buf)
+            if not n:
+                break
+            chunk = view[:n]
+            # zlib and hashlib release the GIL on large buffers, so files hash in parallel.
+            crc = zlib.crc32(chunk, crc)
+            sha1.update(chunk)
+            fast.update(chunk)
+            size += n
+    return FileHashes(size=size, crc32=crc & 0xFFFFFFFF, sha1=sha1.hexdigest(), fast64=fast.hexdigest())
+
+
+def _unchanged(before: os.stat_result, path: Path) -> bool:
+    """Only cache a hash if the file did not change while it was being read."""
+    try:
+        after = rom_stat(path)
+    except OSError:
+        return False
+    return (after.st_size, after.st_mtime_ns) == (before.st_size, before.st_mtime_ns)
+
+
+def _i64(v: int) -> int:
+    """Store unsigned 64-bit st_dev/st_ino in SQLite's signed INTEGER."""
+    return v - (1 << 64) if v >= (1 << 63) else v
+
+
+class HashCache:
+    """
+    Persistent (device, inode, size, mtime_ns) -> FileHashes index. A file
+    whose identity and stat are unchanged is never read again; any rewrite
+    changes mtime (and usually size) and misses. Use from one thread;
+    hash_files does the reading on its pool and the bookkeeping here.
+    """
+
+    def __init__(self, path: Path = DEFAULT_HASH_CACHE) -> None:
+        self.path = Path(path)
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        self._db = sqlite3.connect(str(self.path))
+        self._db.execute("PRAGMA journal_mode=WAL")
+        self._db.execute("PRAGMA synchronous=NORMAL")
+        self._db.execute(
+            "CREATE TABLE IF NOT EXISTS hashes ("
+            " dev INTEGER, ino INTEGER, size INTEGER, mtime_ns INTEGER, algo TEXT,"
+            " crc32 INTEGER, sha1 TEXT, fast64 TEXT, path TEXT,"
+            " PRIMARY KEY (dev, ino, size, mtime_ns, algo))"
+        )
+        self.hits = 0
+        self.misses = 0
+        self._pending = 0
+
+    def get(self, st: os.stat_result) -> Optional[FileHashes]:
+        row = self._db.execute(
+            "SELECT crc32, sha1, fast64 FROM hashes WHERE dev=? AND ino=? AND size=? AND mtime_ns=? AND algo=?",
+            (_i64(st.st_dev), _i64(st.st_ino), st.st_size, st.st_mtime_ns, FAST_HASH_NAME),
+        ).fetchone()
+        if row is None:
+            self.misses += 1
+            return None
+        self.hits += 1
+        return FileHashes(size=st.st_size, crc32=row[0], sha1=row[1], fast64=row[2])
+
+    def put(self, st: os.stat_result, hashes: FileHashes, path: Path) -> None:
+        # A new (dev, ino) row supersedes older versions of the same file.
+        self._db.execute("DELETE FROM hashes WHERE dev=? AND ino=?", (_i64(st.st_dev), _i64(st.st_ino)))
+        self._db.execute(
+            "INSERT OR REPLACE INTO hashes VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)",
+            (_i64(st.st_dev), _i64(st.st_ino), st.st_size, st.st_mtime_ns, FAST_HASH_NAME,
+             hashes.crc32, hashes.sha1, hashes.fast64, str(path)),
+        )
+        # Commit periodically so an interrupted first run keeps most of its work.
+        self._pending += 1
+        if self._pending >= COMMIT_EVERY:
+            self.commit()
+
+    def commit(self) -> None:
+        self._db.commit()
+        self._pending = 0
+
+    def close(self) -> None:
+        self._db.commit()
+        self._db.close()
+
+    def __enter__(self) -> "HashCache":
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
+
+
+def hash_files(
+    paths: Iterable[Path],
+    cache: Optional[HashCache] = None,
+    jobs: int = DEFAULT_HASH_JOBS,
+) -> Dict[Path, FileHashes]:
+    """
+    Hashes for every readable path: cached ones without reading, the rest
+    hashed on `jobs` threads. Each file is queued as soon as paths yields it,
+    so a lazy paths (e.g. fed by discovery) overlaps hashing with producing
+    them. Unreadable files are reported and left out.
+    """
+    results: Dict[Path, FileHashes] = {}
+    todo: Dict[Path, os.stat_result] = {}
+    with ThreadPoolExecutor(max_workers=max(1, jobs), thread_name_prefix="hash") as pool:
+        futures = {}
+        for p in paths:
+            p = Path(p)
+            if p in todo or p in results:
+                continue
+            try:
+                st = rom_stat(p)
+            except OSError as e:
+                print(f"[hash] Skipping {p}: {e}")
+                continue
+            cached = cache.get(st) if cache is not None else None
+            if cached is not None:
+                results[p] = cached
+            else:
+                todo[p] = st
+                futures[pool.submit(hash_file, p, HASH_BUFSIZE, st.st_size)] = p
+        if not todo:
+            return results
+        for fut in as_completed(futures):
+            p = futures[fut]
+            try:
+                h = fut.result()
+            except OSError as e:
+                print(f"[hash] Skipping {p}: {e}")
+                continue
+            results[p] = h
+            if cache is not None and _unchanged(todo[p], p):
+                cache.put(todo[p], h, p)
+    if cache is not None:
+        cache.commit()
+    return results
+
+
+def hash_one(path: Path, cache: Optional[HashCache] = None) -> FileHashes:
+    """Single-file hash_files; raises OSError if the file can't be read."""
+    path = Path(path)
+    st = rom_stat(path)
+    cached = cache.get(st) if cache is not None else None
+    if cached is not None:
+        return cached
+    h = hash_file(path, size_hint=st.st_size)
+    if cache is not None and _unchanged(st, path):
+        cache.put(st, h, path)
+        cache.commit()
+    return h
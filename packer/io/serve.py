@@ -0,0 +1,151 @@
+# packer/io/serve.py
+from __future__ import annotations
+
+import json
+import os
+import re
+import urllib.parse
+from http import HTTPStatus
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from pathlib import Path
+from typing import List, Optional, Tuple
+
+INDEX_PATHS = ("/", "/index.json")
+SERVED_EXTS = (".nsp", ".nro")
+
+_TITLE_ID_RE = re.compile(r"\[([0-9A-Fa-f]{16})\]")
+_RANGE_RE = re.compile(r"^bytes=(\d*)-(\d*)$")
+
+
+def build_index(root: Path) -> dict:
+    """
+    Titles under root. "files" (url + size) is the shape network installers such
+    as Tinfoil/DBI read; "titles" adds the TitleID parsed from '<title> [<tid>].nsp'.
+    """
+    files: List[dict] = []
+    titles: List[dict] = []
+    for p in sorted(root.rglob("*")):
+        if not p.is_file() or p.suffix.lower() not in SERVED_EXTS:
+            continue
+        rel = p.relative_to(root).as_posix()
+        url = "/" + urllib.parse.quote(rel)
+        size = p.stat().st_size
+        m = _TITLE_ID_RE.search(p.stem)
+        files.append({"url": url, "size": size})
+        titles.append({
+            "name": _TITLE_ID_RE.sub("", p.stem).strip(),
+            "type": p.suffix.lower().lstrip("."),
+            "title_id": m.group(1).upper() if m else None,
+            "size": size,
+            "url": url,
+        })
+    return {"files": files, "titles": titles}
+
+
+def parse_range(header: Optional[str], size: int) -> Optional[Tuple[int, int]]:
+    """
+    Single 'bytes=' range -> inclusive (start, end). None means serve the whole
+    file (no header, a multi-range we don't split, or an invalid range such as
+    bytes=5-3, which RFC 7233 says to ignore); raises ValueError if the range
+    is unsatisfiable.
+    """
+    if not header:
+        return None
+    m = _RANGE_RE.match(header.strip())
+    if not m:
+        return None
+    first, last = m.groups()
+    if not first and not last:
+        return None
+    if not first:                       # suffix range: last N bytes
+        n = int(last)
+        if n == 0 or size == 0:
+            raise ValueError("range not satisfiable")
+        return max(0, size - n), size - 1
+    start = int(first)
+    if last and int(last) < start:
+        return None
+    if start >= size:
+        raise ValueError("range not satisfiable")
+    end = min(int(last), size - 1) if last else size - 1
+    return start, end
+
+
+class _OutputHandler(BaseHTTPRequestHandler):
+    server_version = "switch-rom-packer"
+    protocol_version = "HTTP/1.1"
+    root: Path = Path(".")
+
+    def do_HEAD(self) -> None:
+        self._serve(head=True)
+
+    def do_GET(self) -> None:
+        self._serve(head=False)
+
+    def log_message(self, fmt: str, *args) -> None:
+        print(f"[serve] {self.address_string()} {fmt % args}")
+
+    def _serve(self, head: bool) -> None:
+        path = urllib.parse.unquote(urllib.parse.urlsplit(self.path).path)
+        if path in INDEX_PATHS:
+            body = json.dumps(build_index(self.root), indent=1).encode("utf-8")
+            self.send_response(HTTPStatus.OK)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            if not head:
+                self.wfile.write(body)
+            return
+
+        target = self._resolve(path)
+        if target is None:
+            self.send_error(HTTPStatus.NOT_FOUND)
+            return
+
+        with target.open("rb") as f:
+            size = os.fstat(f.fileno()).st_size
+            try:
+                rng = parse_range(self.headers.get("Range"), size)
+            except ValueError:
+                self.send_response(HTTPStatus.REQUESTED_RANGE_NOT_SATISFIABLE)
+                self.send_header("Content-Range", f"bytes */{size}")
+                self.send_header("Content-Length", "0")
+                self.end_headers()
+                return
+
+            start, end = rng if rng else (0, size - 1)
+            count = max(0, end - start + 1)
+            self.send_response(HTTPStatus.PARTIAL_CONTENT if rng else HTTPStatus.OK)
+            self.send_header("Content-Type", "application/octet-stream")
+            self.send_header("Accept-Ranges", "bytes")
+            self.send_header("Content-Length", str(count))
+            if rng:
+                self.send_header("Content-Range", f"bytes {start}-{end}/{size}")
+            self.end_headers()
+            if head or count == 0:
+                return
+            self.wfile.flush()
+            # socket.sendfile uses os.sendfile (zero-copy) where available.
+            self.connection.sendfile(f, offset=start, count=count)
+
+    def _resolve(self, url_path: str) -> Optional[Path]:
+        """Map a URL path to a served file inside root, refusing anything outside it."""
+        rel = url_path.lstrip("/")
+        if not rel:
+            return None
+        candidate = (self.root / rel).resolve()
+        try:
+            candidate.relative_to(self.root)
+        except ValueError:
+            return None
+        if not candidate.is_file() or candidate.suffix.lower() not in SERVED_EXTS:
+            return None
+        return candidate
+
+
+def make_server(root: Path, host: str = "0.0.0.0", port: int = 8000) -> ThreadingHTTPServer:
+    """Create (not start) a threaded server exposing root's NSPs/NROs and index.json."""
+    handler = type("OutputHandler", (_OutputHandler,), {"root": Path(root).resolve()})
+    server = ThreadingHTTPServer((host, port), handler)
+    server.daemon_threads = True
+    return server
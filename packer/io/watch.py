@@ -0,0 +1,187 @@
+# packer/io/watch.py
+from __future__ import annotations
+
+import ctypes
+import ctypes.util
+import errno
+import os
+import select
+import struct
+import time
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Dict, Iterator, Optional, Set
+
+# <sys/inotify.h>
+IN_CLOSE_WRITE = 0x00000008
+IN_MOVED_FROM = 0x00000040
+IN_MOVED_TO = 0x00000080
+IN_CREATE = 0x00000100
+IN_DELETE = 0x00000200
+IN_DELETE_SELF = 0x00000400
+IN_MOVE_SELF = 0x00000800
+IN_Q_OVERFLOW = 0x00004000
+IN_IGNORED = 0x00008000
+IN_ONLYDIR = 0x01000000
+IN_ISDIR = 0x40000000
+IN_NONBLOCK = 0o4000
+IN_CLOEXEC = 0o2000000
+
+WATCH_MASK = (
+    IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_CREATE | IN_DELETE
+    | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR
+)
+
+_EVENT = struct.Struct("iIII")      # wd, mask, cookie, len (+ name[len])
+
+DEFAULT_DEBOUNCE = 1.0
+DEFAULT_POLL_INTERVAL = 5.0
+
+
+@dataclass
+class ChangeBatch:
+    """
+    One debounced burst of changes. written holds files closed after writing
+    or moved in (candidates for a rebuild); rescan is set when entries were
+    created, removed or renamed, or events were lost, so the tree listing must
+    be refreshed.
+    """
+    written: Set[Path] = field(default_factory=set)
+    rescan: bool = False
+
+
+class Inotify:
+    """Minimal ctypes binding; raises OSError where inotify is unavailable."""
+
+    def __init__(self) -> None:
+        libc_name = ctypes.util.find_library("c")
+        if not libc_name or not hasattr(os, "O_NONBLOCK"):
+            raise OSError(errno.ENOSYS, "inotify unavailable")
+        self._libc = ctypes.CDLL(libc_name, use_errno=True)
+        if not hasattr(self._libc, "inotify_init1"):
+            raise OSError(errno.ENOSYS, "inotify unavailable")
+        self.fd = self._libc.inotify_init1(IN_NONBLOCK | IN_CLOEXEC)
+        if self.fd < 0:
+            err = ctypes.get_errno()
+            raise OSError(err, os.strerror(err))
+        self.paths: Dict[int, Path] = {}
+
+    def add_watch(self, path: Path, mask: int = WATCH_MASK) -> int:
+        wd = self._libc.inotify_add_watch(self.fd, os.fsencode(str(path)), mask)
+        if wd < 0:
+            err = ctypes.get_errno()
+            raise OSError(err, os.strerror(err), str(path))
+        self.paths[wd] = Path(path)
+        return wd
+
+    def read_events(self) -> Iterator[tuple[int, int, Optional[Path]]]:
+        """Yield (wd, mask, full path or None) for every queued event; never blocks."""
+        while True:
+            try:
+                buf = os.read(self.fd, 64 * 1024)
+            except BlockingIOError:
+                return
+            off = 0
+            while off + _EVENT.size <= len(buf):
+                wd, mask, _cookie, length = _EVENT.unpack_from(buf, off)
+                off += _EVENT.size
+                name = buf[off:off + length].rstrip(b"\0")
+                off += length
+                parent = self.paths.get(wd)
+                if mask & IN_IGNORED:
+                    self.paths.pop(wd, None)
+                yield wd, mask, (parent / os.fsdecode(name)) if parent is not None and name else parent
+
+    def close(self) -> None:
+        if self.fd >= 0:
+            os.close(self.fd)
+            self.fd = -1
+
+
+def _walk_dirs(root: Path, max_depth: int) -> Iterator[Path]:
+    """root and the directories up to max_depth levels below it."""
+    stack = [(Path(root), 0)]
+    while stack:
+        d, depth = stack.pop()
+        yield d
+        if depth >= max_depth:
+            continue
+        try:
+            with os.scandir(d) as it:
+                for e in it:
+                    if not e.name.startswith(".") and e.is_dir(follow_symlinks=depth == 0):
+                        stack.append((Path(e.path), depth + 1))
+        except OSError:
+            continue
+
+
+def _depth_of(root: Path, path: Path) -> int:
+    try:
+        return len(path.relative_to(root).parts)
+    except ValueError:
+        return 0
+
+
+def watch_tree(
+    root: Path,
+    max_depth: int,
+    debounce: float = DEFAULT_DEBOUNCE,
+    poll_interval: float = DEFAULT_POLL_INTERVAL,
+) -> Iterator[ChangeBatch]:
+    """
+    Yield a ChangeBatch each time the tree under root settles after changes
+    (no events for `debounce` seconds). Uses inotify on Linux; elsewhere it
+    yields a rescan batch every poll_interval seconds, which callers keep cheap
+    with the mtime-keyed discovery cache.
+    """
+    root = Path(root)
+    try:
+        ino = Inotify()
+    except OSError as e:
+        print(f"[watch] inotify unavailable ({e}); polling every {poll_interval:g}s")
+        while True:
+            time.sleep(poll_interval)
+            yield ChangeBatch(rescan=True)
+
+    def _add_tree(top: Path, base_depth: int) -> None:
+        for d in _walk_dirs(top, max_depth - base_depth):
+            try:
+                ino.add_watch(d)
+            except OSError as e:
+                if e.errno == errno.ENOSPC:
+                    print("[watch] WARNING: inotify watch limit reached; raise fs.inotify.max_user_watches")
+                    return
+                # Vanished in the meantime; the next rescan will catch up.
+
+    try:
+        _add_tree(root, -1)     # root, platform folders, then max_depth levels below them
+        print(f"[watch] Watching {len(ino.paths)} director(ies) under {root}")
+        poller = select.poll()
+        poller.register(ino.fd, select.POLLIN)
+        batch = ChangeBatch()
+        while True:
+            timeout = debounce * 1000 if (batch.written or batch.rescan) else None
+            if not poller.poll(timeout):
+                if batch.written or batch.rescan:
+                    yield batch
+                    batch = ChangeBatch()
+                continue
+            for _wd, mask, path in ino.read_events():
+                if mask & IN_Q_OVERFLOW:
+                    batch.rescan = True
+                    continue
+                if path is None:
+                    continue
+                if mask & IN_ISDIR:
+                    batch.rescan = True
+                    if mask & (IN_CREATE | IN_MOVED_TO):
+                        depth = _depth_of(root, path)
+                        if depth <= max_depth + 1:
+                            _add_tree(path, depth - 1)
+                    continue
+                if mask & (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF):
+                    batch.rescan = True
+                if mask & (IN_CLOSE_WRITE | IN_MOVED_TO):
+                    batch.written.add(path)
+    finally:
+        ino.close()
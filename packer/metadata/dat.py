@@ -0,0 +1,186 @@
+# packer/metadata/dat.py
+from __future__ import annotations
+
+import os
+import sqlite3
+import xml.etree.ElementTree as ET
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Iterable, Iterator, List, Optional, Tuple
+
+# Cache root: ~/.switch-rom-packer/cache/dat.sqlite
+DEFAULT_DAT_INDEX = Path.home() / ".switch-rom-packer" / "cache" / "dat.sqlite"
+DAT_EXTS = (".dat", ".xml")
+_BATCH = 5000
+
+# libretro-thumbnails replaces these with '_' in file names.
+_THUMBNAIL_UNSAFE = '&*/:`<>?\\|"'
+
+
+@dataclass(frozen=True)
+class DatMatch:
+    game: str           # No-Intro/Redump game name, e.g. "Super Metroid (Japan, USA) (En,Ja)"
+    rom: str            # file name inside the set
+    system: str         # DAT header name, e.g. "Nintendo - Super Nintendo Entertainment System"
+
+    @property
+    def thumbnail_name(self) -> str:
+        """Exact libretro-thumbnails base name (without .png) for this game."""
+        return "".join("_" if c in _THUMBNAIL_UNSAFE else c for c in self.game)
+
+
+def iter_dat_roms(path: Path) -> Iterator[Tuple[str, str, str, Optional[int], Optional[int], Optional[str]]]:
+    """
+    Stream (system, game, rom, size, crc32, sha1) from a Logiqx-format DAT
+    (No-Intro, Redump) with iterparse, clearing each game once read so memory
+    stays flat regardless of DAT size.
+    """
+    system = ""
+    in_header = False
+    context = ET.iterparse(str(path), events=("start", "end"))
+    _, root = next(context)
+    for event, elem in context:
+        tag = elem.tag
+        if tag == "header":
+            in_header = event == "start"
+            continue
+        if event != "end":
+            continue
+        if tag == "name" and in_header:
+            system = (elem.text or "").strip()
+        elif tag in ("game", "machine"):
+            game = elem.get("name") or ""
+            for rom in elem.iter("rom"):
+                crc = rom.get("crc")
+                size = rom.get("size")
+                sha1 = rom.get("sha1")
+                yield (
+                    system,
+                    game,
+                    rom.get("name") or "",
+                    int(size) if size and size.isdigit() else None,
+                    int(crc, 16) if crc else None,
+                    sha1.lower() if sha1 else None,
+                )
+            root.clear()
+
+
+class DatIndex:
+    """
+    CRC32/SHA1 -> game lookup over imported DAT files, in SQLite (indexed
+    lookups, nothing loaded up front). DATs are re-imported only when their
+    size or mtime changes.
+    """
+
+    def __init__(self, path: Path = DEFAULT_DAT_INDEX) -> None:
+        self.path = Path(path)
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        self._db = sqlite3.connect(str(self.path))
+        self._db.executescript(
+            """
+            PRAGMA journal_mode=WAL;
+            CREATE TABLE IF NOT EXISTS dats (
+                id INTEGER PRIMARY KEY, path TEXT UNIQUE, size INTEGER, mtime_ns INTEGER, system TEXT);
+            CREATE TABLE IF NOT EXISTS roms (
+                dat INTEGER, game TEXT, rom TEXT, size INTEGER, crc32 INTEGER, sha1 TEXT);
+            CREATE INDEX IF NOT EXISTS roms_crc32 ON roms (crc32);
+            CREATE INDEX IF NOT EXISTS roms_sha1 ON roms (sha1);
+            """
+        )
+        # DATs named this run; lookups ignore anything imported earlier but not listed now.
+        self._active: List[int] = []
+
+    def import_dat(self, path: Path) -> int:
+        """Import (or refresh) one DAT. Returns the number of ROM rows, 0 if unchanged."""
+        path = Path(path).resolve()
+        st = path.stat()
+        row = self._db.execute("SELECT id, size, mtime_ns FROM dats WHERE path=?", (str(path),)).fetchone()
+        if row and (row[1], row[2]) == (st.st_size, st.st_mtime_ns):
+            self._active.append(row[0])
+            return 0
+        with self._db:
+            if row:
+                self._db.execute("DELETE FROM roms WHERE dat=?", (row[0],))
+                self._db.execute("DELETE FROM dats WHERE id=?", (row[0],))
+            dat_id = self._db.execute(
+                "INSERT INTO dats (path, size, mtime_ns, system) VALUES (?, ?, ?, '')",
+                (str(path), st.st_size, st.st_mtime_ns),
+            ).lastrowid
+            count = 0
+            system = ""
+            batch: List[tuple] = []
+            for system, game, rom, size, crc, sha1 in iter_dat_roms(path):
+                batch.append((dat_id, game, rom, size, crc, sha1))
+                if len(batch) >= _BATCH:
+                    self._db.executemany("INSERT INTO roms VALUES (?, ?, ?, ?, ?, ?)", batch)
+                    count += len(batch)
+                    batch.clear()
+            self._db.executemany("INSERT INTO roms VALUES (?, ?, ?, ?, ?, ?)", batch)
+            count += len(batch)
+            self._db.execute("UPDATE dats SET system=? WHERE id=?", (system, dat_id))
+        self._active.append(dat_id)
+        return count
+
+    def import_paths(self, paths: Iterable[Path]) -> None:
+        """--dat: DAT files, or directories containing them."""
+        for p in paths:
+            p = Path(p)
+            files = sorted(f for f in p.rglob("*") if f.suffix.lower() in DAT_EXTS) if p.is_dir() else [p]
+            if not files:
+                print(f"[dat] No .dat/.xml files under {p}")
+            for f in files:
+                try:
+                    n = self.import_dat(f)
+                except (OSError, ValueError, ET.ParseError) as e:
+                    print(f"[dat] Skipping {f}: {e}")
+                    continue
+                if n:
+                    print(f"[dat] Imported {n} ROM(s) from {f.name}")
+
+    def lookup(
+        self,
+        crc32: int,
+        sha1: Optional[str] = None,
+        size: Optional[int] = None,
+        platform: Optional[str] = None,
+    ) -> Optional[DatMatch]:
+        """
+        SHA1 match if known, else CRC32 (+size when the DAT lists it). A hit in
+        the DAT for platform wins over other systems.
+        """
+        scope = f" AND roms.dat IN ({','.join('?' * len(self._active))})" if self._active else ""
+        q = (
+            "SELECT roms.game, roms.rom, dats.system FROM roms JOIN dats ON dats.id = roms.dat "
+            "WHERE {cond}" + scope + " ORDER BY dats.system = ? DESC LIMIT 1"
+        )
+        row = None
+        if sha1:
+            row = self._db.execute(
+                q.format(cond="roms.sha1=?"), (sha1.lower(), *self._active, platform or "")
+            ).fetchone()
+        if row is None:
+            row = self._db.execute(
+                q.format(cond="roms.crc32=? AND (roms.size IS NULL OR ? IS NULL OR roms.size=?)"),
+                (crc32 & 0xFFFFFFFF, size, size, *self._active, platform or ""),
+            ).fetchone()
+        return DatMatch(game=row[0], rom=row[1], system=row[2]) if row else None
+
+    def __len__(self) -> int:
+        if not self._active:
+            return self._db.execute("SELECT COUNT(*) FROM roms").fetchone()[0]
+        return self._db.execute(
+            f"SELECT COUNT(*) FROM roms WHERE dat IN ({','.join('?' * len(self._active))})", self._active
+        ).fetchone()[0]
+
+    def close(self) -> None:
+        self._db.close()
+
+
+def open_dat_index(paths: Iterable[Path], index_path: Path = DEFAULT_DAT_INDEX) -> Optional[DatIndex]:
+    paths = list(paths)
+    if not paths:
+        return None
+    index = DatIndex(index_path)
+    index.import_paths(paths)
+    print(f"[dat] Index has {len(index)} ROM(s) ({os.fspath(index.path)})")
+    return index
@@ -63,8 +63,12 @@ def parse_rom_title(rom_path: str) -> Tuple[str, List[str]]:
         -> canonical: 'The 7th Saga'
         -> alts: ['Seventh Saga', '7th Saga, The', '7th Saga', 'The Seventh Saga', ...]
     """
-    stem = Path(rom_path).stem
-    raw = _strip_tags(stem)
+    return parse_title_name(Path(rom_path).stem)
+
+
+def parse_title_name(name: str) -> Tuple[str, List[str]]:
+    """parse_rom_title for a bare name (e.g. a DAT game name, which may contain dots)."""
+    raw = _strip_tags(name)
 
     # Base variants
     art_fixed = _move_trailing_article(raw)
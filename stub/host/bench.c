@@ -0,0 +1,418 @@
+// stub/host/bench.c
+// Linux harness for the extraction engine (make host-bench / make host-test).
+// A temp directory stands in for romfs:/ and another for sdmc:/.
+//
+//   extract-bench [--quick] [--check] [--workers N] [--buffers 65536,262144,...]
+//                 [--romfs DIR]
+//
+// Without --romfs a synthetic matrix of entry counts and file sizes is
+// generated; --romfs benchmarks an existing packer-produced RomFS directory
+// (one containing manifest.bin). --check additionally exercises journal resume
+// and exits non-zero on any verification failure.
+#define _GNU_SOURCE
+#include <errno.h>
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "extract.h"
+
+typedef struct {
+    const char* name;
+    u32         count;
+    u64         size;
+} Scenario;
+
+static const Scenario kFull[] = {
+    { "1 x 256 MiB",   1,    256ull << 20 },
+    { "16 x 16 MiB",   16,   16ull << 20 },
+    { "256 x 256 KiB", 256,  256ull << 10 },
+    { "2048 x 4 KiB",  2048, 4ull << 10 },
+};
+
+static const Scenario kQuick[] = {
+    { "1 x 24 MiB",   1,   24ull << 20 },
+    { "64 x 64 KiB",  64,  64ull << 10 },
+    { "256 x 1 KiB",  256, 1ull << 10 },
+};
+
+static const size_t kDefaultBuffers[] = { 64 << 10, 256 << 10, 1 << 20, 4 << 20 };
+
+static int rmEntry(const char* path, const struct stat* st, int flag, struct FTW* ftw) {
+    (void)st; (void)flag; (void)ftw;
+    return remove(path);
+}
+
+static void rmTree(const char* path) {
+    nftw(path, rmEntry, 32, FTW_DEPTH | FTW_PHYS);
+}
+
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char* pathf(const char* fmt, const char* a, const char* b) {
+    size_t len = strlen(fmt) + strlen(a) + (b ? strlen(b) : 0) + 1;
+    char* out = malloc(len);
+    snprintf(out, len, fmt, a, b ? b : "");
+    return out;
+}
+
+// ---- fixture generation (mirrors packer/io/filelist.py encode_manifest) ----
+
+typedef struct {
+    u8*    buf;
+    size_t len, cap;
+} Buf;
+
+static u32 bufPut(Buf* b, const void* p, size_t n) {
+    if (b->len + n > b->cap) {
+        b->cap = (b->len + n) * 2;
+        b->buf = realloc(b->buf, b->cap);
+    }
+    memcpy(b->buf + b->len, p, n);
+    b->len += n;
+    return (u32)(b->len - n);
+}
+
+static u32 strtabAdd(Buf* strtab, const char* s) {
+    return bufPut(strtab, s, strlen(s) + 1);
+}
+
+static bool writeFixture(const char* romfsDir, const Scenario* sc) {
+    mkdir(romfsDir, 0777);
+
+    const char* platform = "Bench";
+    Buf strtab = {0};
+    ManifestEntry* entries = calloc(sc->count, sizeof(ManifestEntry));
+    u32 platformOff = strtabAdd(&strtab, platform);
+
+    size_t chunk = 1 << 20;
+    u8* data = malloc(chunk);
+    u64 seed = 0x9E3779B97F4A7C15ull;
+    for (u32 i = 0; i < sc->count; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "rom_%05u.bin", i);
+        char* path = pathf("%s/%s", romfsDir, name);
+        FILE* f = fopen(path, "wb");
+        free(path);
+        if (!f) return false;
+
+        u32 crc = 0;
+        for (u64 left = sc->size; left;) {
+            size_t n = left < chunk ? (size_t)left : chunk;
+            for (size_t k = 0; k < n; k += 8) {
+                seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+                memcpy(data + k, &seed, n - k < 8 ? n - k : 8);
+            }
+            crc = portCrc32(crc, data, n);
+            fwrite(data, 1, n, f);
+            left -= n;
+        }
+        fclose(f);
+
+        entries[i].size         = sc->size;
+        entries[i].crc32        = crc;
+        entries[i].codec        = MANIFEST_CODEC_NONE;
+        entries[i].flags        = MANIFEST_ENTRY_VERIFY_CRC;
+        entries[i].src_off      = strtabAdd(&strtab, name);
+        entries[i].platform_off = platformOff;
+        entries[i].dest_off     = MANIFEST_NO_STRING;
+    }
+    free(data);
+
+    u32 dirs[2] = { strtabAdd(&strtab, "/roms"), strtabAdd(&strtab, "/roms/Bench") };
+
+    ManifestHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, MANIFEST_MAGIC, 4);
+    hdr.version        = MANIFEST_VERSION;
+    hdr.header_size    = sizeof(ManifestHeader);
+    hdr.entry_count    = sc->count;
+    hdr.entry_size     = sizeof(ManifestEntry);
+    hdr.entries_offset = sizeof(ManifestHeader);
+    hdr.dir_count      = 2;
+    hdr.dirs_offset    = hdr.entries_offset + sc->count * (u32)sizeof(ManifestEntry);
+    hdr.strtab_offset  = hdr.dirs_offset + sizeof(dirs);
+    hdr.strtab_size    = (u32)strtab.len;
+
+    char* mpath = pathf("%s/%s", romfsDir, MANIFEST_FILE);
+    FILE* m = fopen(mpath, "wb");
+    free(mpath);
+    if (!m) return false;
+    fwrite(&hdr, 1, sizeof(hdr), m);
+    fwrite(entries, sizeof(ManifestEntry), sc->count, m);
+    fwrite(dirs, 1, sizeof(dirs), m);
+    fwrite(strtab.buf, 1, strtab.len, m);
+    fclose(m);
+
+    free(entries);
+    free(strtab.buf);
+    return true;
+}
+
+// ---- verification ----
+
+static bool fileCrc(const char* path, u64* size, u32* crc) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    static u8 buf[1 << 16];
+    size_t n;
+    *size = 0;
+    *crc = 0;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        *crc = portCrc32(*crc, buf, n);
+        *size += n;
+    }
+    fclose(f);
+    return true;
+}
+
+// Destination the engine uses for an entry (see extractEntry).
+static char* destPath(const char* sdDir, const u8* data, const ManifestHeader* hdr, const ManifestEntry* e) {
+    const char* strs = (const char*)data + hdr->strtab_offset;
+    if (e->dest_off != MANIFEST_NO_STRING) return pathf("%s%s", sdDir, strs + e->dest_off);
+    const char* src  = strs + e->src_off;
+    const char* base = strrchr(src, '/') ? strrchr(src, '/') + 1 : src;
+    const char* plat = strs + e->platform_off;
+    size_t len = strlen(sdDir) + strlen(EXTRACT_OUTPUT_BASE) + strlen(plat) + 1 + strlen(base) + 1;
+    char* out = malloc(len);
+    snprintf(out, len, "%s" EXTRACT_OUTPUT_BASE "%s/%s", sdDir, plat, base);
+    return out;
+}
+
+static u32 verifyOutputs(const char* sdDir, const u8* data, const ManifestHeader* hdr) {
+    u32 bad = 0;
+    for (u32 i = 0; i < hdr->entry_count; i++) {
+        const ManifestEntry* e = (const ManifestEntry*)(data + hdr->entries_offset + (size_t)i * hdr->entry_size);
+        char* dst = destPath(sdDir, data, hdr, e);
+        u64 size; u32 crc;
+        if (!fileCrc(dst, &size, &crc) || size != e->size || crc != e->crc32) {
+            fprintf(stderr, "verify: mismatch for %s\n", dst);
+            bad++;
+        }
+        free(dst);
+    }
+    return bad;
+}
+
+// ---- runs ----
+
+typedef struct {
+    u32 workers;
+    bool check;
+    u32 failures;
+} Options;
+
+static void printHeader(void) {
+    printf("%-16s %8s %4s %10s %8s %8s %8s %7s %7s %7s %6s\n",
+           "scenario", "buffer", "thr", "MB/s", "opens", "reads", "writes", "mkdirs", "stats", "renames", "syncs");
+}
+
+static void runOnce(Options* opt, const char* label, const char* base, const char* romfsDir,
+                    size_t bufferSize) {
+    char* manifestPath = pathf("%s/%s", romfsDir, MANIFEST_FILE);
+    size_t size = 0;
+    u8* data = extractLoadManifest(manifestPath, &size, NULL);
+    free(manifestPath);
+    const ManifestHeader* hdr = data ? extractValidateManifest(data, size) : NULL;
+    if (!hdr) {
+        fprintf(stderr, "bench: %s/%s missing or invalid\n", romfsDir, MANIFEST_FILE);
+        opt->failures++;
+        free(data);
+        return;
+    }
+
+    char* sdDir = pathf("%s/sd%s", base, "");
+    rmTree(sdDir);
+    mkdir(sdDir, 0777);
+    char* romfsRoot = pathf("%s/%s", romfsDir, "");
+
+    ExtractConfig cfg;
+    extractConfigDefaults(&cfg);
+    cfg.romfsRoot  = romfsRoot;
+    cfg.sdRoot     = sdDir;
+    cfg.bufferSize = bufferSize;
+    cfg.maxWorkers = opt->workers;
+    cfg.quiet      = true;
+
+    ExtractStats st;
+    memset(&st, 0, sizeof(st));
+    double t0 = nowSeconds();
+    u32 failures = extractAll(&cfg, data, hdr, &st);
+    double secs = nowSeconds() - t0;
+
+    char bufLabel[32];
+    if (bufferSize >= (1 << 20)) snprintf(bufLabel, sizeof(bufLabel), "%zuM", bufferSize >> 20);
+    else                         snprintf(bufLabel, sizeof(bufLabel), "%zuK", bufferSize >> 10);
+    printf("%-16s %8s %4u %10.1f %8llu %8llu %8llu %7llu %7llu %7llu %6llu\n",
+           label, bufLabel, opt->workers,
+           secs > 0 ? (st.bytesWritten / (1024.0 * 1024.0)) / secs : 0.0,
+           (unsigned long long)st.opens, (unsigned long long)st.reads,
+           (unsigned long long)st.writes, (unsigned long long)st.mkdirs,
+           (unsigned long long)st.stats, (unsigned long long)st.renames,
+           (unsigned long long)st.syncs);
+
+    opt->failures += failures;
+    if (opt->check) opt->failures += verifyOutputs(sdDir, data, hdr);
+
+    rmTree(sdDir);
+    free(romfsRoot);
+    free(sdDir);
+    free(data);
+}
+
+// Rewind a fully extracted entry to a half-written part file with a journal
+// for it. With corrupt set, a committed byte no longer matches the journal.
+static void makePartial(const char* dst, const char* part, const char* jnl, const ManifestEntry* e, bool corrupt) {
+    u64 committed = e->size / 2;
+    u32 crc = 0;
+    FILE* in = fopen(dst, "rb");
+    FILE* out = fopen(part, "wb");
+    u8* buf = malloc(1 << 16);
+    for (u64 left = committed; in && out && left;) {
+        size_t n = fread(buf, 1, left < (1 << 16) ? (size_t)left : (1 << 16), in);
+        if (!n) break;
+        crc = portCrc32(crc, buf, n);
+        if (corrupt && left == committed) buf[0] ^= 0xFF;
+        fwrite(buf, 1, n, out);
+        left -= n;
+    }
+    // Garbage past the committed offset must be truncated away on resume.
+    memset(buf, 0xAB, 4096);
+    if (out) fwrite(buf, 1, 4096, out);
+    if (in) fclose(in);
+    if (out) fclose(out);
+    free(buf);
+    remove(dst);
+
+    struct __attribute__((packed)) {
+        char magic[4]; u32 version; u64 size; u32 crc32; u32 running_crc; u64 committed;
+    } j = { {'S','R','P','J'}, 1, e->size, e->crc32, crc, committed };
+    FILE* jf = fopen(jnl, "wb");
+    if (jf) { fwrite(&j, 1, sizeof(j), jf); fclose(jf); }
+}
+
+// Simulate an interrupted copy and make sure the next run resumes and
+// verifies; a part file that disagrees with its journal must be redone, and a
+// same-size destination with other content must be replaced, not skipped.
+static void checkResume(Options* opt, const char* base, const char* romfsDir) {
+    char* manifestPath = pathf("%s/%s", romfsDir, MANIFEST_FILE);
+    size_t size = 0;
+    u8* data = extractLoadManifest(manifestPath, &size, NULL);
+    free(manifestPath);
+    const ManifestHeader* hdr = data ? extractValidateManifest(data, size) : NULL;
+    if (!hdr || hdr->entry_count == 0) { free(data); opt->failures++; return; }
+
+    char* sdDir = pathf("%s/sd%s", base, "");
+    rmTree(sdDir);
+    mkdir(sdDir, 0777);
+    char* romfsRoot = pathf("%s/%s", romfsDir, "");
+
+    ExtractConfig cfg;
+    extractConfigDefaults(&cfg);
+    cfg.romfsRoot    = romfsRoot;
+    cfg.sdRoot       = sdDir;
+    cfg.journalChunk = 1 << 20;
+    cfg.quiet        = true;
+
+    // First pass fully extracts, giving us real journal-compatible inputs.
+    ExtractStats st;
+    memset(&st, 0, sizeof(st));
+    extractAll(&cfg, data, hdr, &st);
+
+    const ManifestEntry* e = (const ManifestEntry*)(data + hdr->entries_offset);
+    char* dst  = destPath(sdDir, data, hdr, e);
+    char* part = pathf("%s%s", dst, ".part");
+    char* jnl  = pathf("%s%s", dst, ".part.jnl");
+    struct stat tmp;
+
+    static const char* const kCases[] = { "resume", "corrupt part", "stale destination" };
+    for (u32 c = 0; c < 3; c++) {
+        if (c < 2) {
+            makePartial(dst, part, jnl, e, c == 1);
+        } else {
+            FILE* f = fopen(dst, "r+b");
+            int first = f ? fgetc(f) : EOF;
+            if (f) { fseek(f, 0, SEEK_SET); fputc(first ^ 0xFF, f); fclose(f); }
+        }
+        memset(&st, 0, sizeof(st));
+        u32 failures = extractAll(&cfg, data, hdr, &st);
+        u32 bad = verifyOutputs(sdDir, data, hdr);
+        bool leftovers = stat(part, &tmp) == 0 || stat(jnl, &tmp) == 0;
+        bool ok = failures == 0 && bad == 0 && !leftovers
+               && st.resumed == (c == 0 ? 1u : 0u) && st.skipped == hdr->entry_count - 1;
+        printf("%s check: %s (resumed=%u, skipped=%u, failures=%u)\n",
+               kCases[c], ok ? "ok" : "FAILED", st.resumed, st.skipped, failures + bad);
+        if (!ok) opt->failures++;
+    }
+
+    rmTree(sdDir);
+    free(dst); free(part); free(jnl);
+    free(romfsRoot);
+    free(sdDir);
+    free(data);
+}
+
+static size_t parseBuffers(const char* arg, size_t* out, size_t max) {
+    size_t n = 0;
+    char* copy = strdup(arg);
+    for (char* tok = strtok(copy, ","); tok && n < max; tok = strtok(NULL, ","))
+        out[n++] = (size_t)strtoull(tok, NULL, 0);
+    free(copy);
+    return n;
+}
+
+int main(int argc, char* argv[]) {
+    Options opt = { .workers = EXTRACT_MAX_WORKERS };
+    bool quick = false;
+    const char* romfs = NULL;
+    size_t buffers[16];
+    size_t bufferCount = sizeof(kDefaultBuffers) / sizeof(kDefaultBuffers[0]);
+    memcpy(buffers, kDefaultBuffers, sizeof(kDefaultBuffers));
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--quick")) quick = true;
+        else if (!strcmp(argv[i], "--check")) opt.check = true;
+        else if (!strcmp(argv[i], "--workers") && i + 1 < argc) opt.workers = (u32)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--buffers") && i + 1 < argc) bufferCount = parseBuffers(argv[++i], buffers, 16);
+        else if (!strcmp(argv[i], "--romfs") && i + 1 < argc) romfs = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--quick] [--check] [--workers N] [--buffers a,b,...] [--romfs DIR]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    char base[] = "/tmp/srp-bench-XXXXXX";
+    if (!mkdtemp(base)) { perror("mkdtemp"); return 1; }
+
+    printHeader();
+    if (romfs) {
+        for (size_t b = 0; b < bufferCount; b++) runOnce(&opt, "romfs", base, romfs, buffers[b]);
+    } else {
+        const Scenario* list = quick ? kQuick : kFull;
+        size_t count = quick ? sizeof(kQuick) / sizeof(kQuick[0]) : sizeof(kFull) / sizeof(kFull[0]);
+        char* romfsDir = pathf("%s/romfs%s", base, "");
+        for (size_t s = 0; s < count; s++) {
+            rmTree(romfsDir);
+            if (!writeFixture(romfsDir, &list[s])) {
+                fprintf(stderr, "bench: failed to write fixture %s\n", list[s].name);
+                opt.failures++;
+                continue;
+            }
+            for (size_t b = 0; b < bufferCount; b++) runOnce(&opt, list[s].name, base, romfsDir, buffers[b]);
+            if (opt.check && s == 0) checkResume(&opt, base, romfsDir);
+        }
+        free(romfsDir);
+    }
+
+    rmTree(base);
+    if (opt.failures) fprintf(stderr, "bench: %u failure(s)\n", opt.failures);
+    return opt.failures ? 1 : 0;
+}
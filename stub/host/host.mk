@@ -0,0 +1,29 @@
+#---------------------------------------------------------------------------------
+# host/host.mk — Linux build of the portable extraction engine (no devkitPro).
+#
+#   make host-bench [BENCH_ARGS="--buffers 65536,1048576 --workers 1"]
+#   make host-test      quick matrix + journal resume check, non-zero on failure
+#   make host-clean
+#---------------------------------------------------------------------------------
+HOST_CC     ?= cc
+HOST_CFLAGS ?= -O2 -g -Wall -Wextra -std=gnu11
+HOST_BUILD  := build-host
+HOST_BENCH  := $(HOST_BUILD)/extract-bench
+
+HOST_SRCS   := source/extract.c source/port.c host/bench.c
+HOST_HDRS   := $(wildcard include/*.h)
+
+.PHONY: host-bench host-test host-clean
+
+host-bench: $(HOST_BENCH)
+	$(HOST_BENCH) $(BENCH_ARGS)
+
+host-test: $(HOST_BENCH)
+	$(HOST_BENCH) --quick --check
+
+$(HOST_BENCH): $(HOST_SRCS) $(HOST_HDRS)
+	@mkdir -p $(HOST_BUILD)
+	$(HOST_CC) $(HOST_CFLAGS) -Iinclude $(HOST_SRCS) -o $@ -lpthread
+
+host-clean:
+	@rm -rf $(HOST_BUILD)
@@ -0,0 +1,55 @@
+// stub/include/extract.h
+// Portable manifest extraction engine shared by the console stub (main.c) and
+// the Linux benchmark harness (host/bench.c).
+#pragma once
+
+#include "manifest.h"
+#include "port.h"
+
+#define EXTRACT_DEFAULT_BUFSZ        (256 * 1024)
+#define EXTRACT_DEFAULT_LARGE_BYTES  (16ull * 1024 * 1024)
+#define EXTRACT_DEFAULT_JOURNAL      (8ull * 1024 * 1024)
+#define EXTRACT_MAX_WORKERS          2       // application cores 1-2
+#define EXTRACT_FIRST_WORKER_CORE    1       // core 0 stays with the main (UI) thread
+
+// Default destination root for entries without an override, relative to sdRoot.
+#define EXTRACT_OUTPUT_BASE "/roms/"
+
+enum {
+    EXTRACT_OK            =  0,
+    EXTRACT_ERR_NOT_FOUND = -1,
+    EXTRACT_ERR_IO        = -2,
+    EXTRACT_ERR_BAD_INPUT = -3,
+    EXTRACT_ERR_NO_MEMORY = -4,
+};
+
+typedef struct {
+    const char* romfsRoot;       // prefix for entry sources, e.g. "romfs:/"
+    const char* sdRoot;          // prefix for destinations (which start with '/'), e.g. "sdmc:"
+    size_t      bufferSize;      // copy buffer per thread
+    u64         largeEntryBytes; // entries this big are streamed sequentially
+    u64         journalChunk;    // bytes between journal commits
+    u32         maxWorkers;      // extra threads for small entries (<= EXTRACT_MAX_WORKERS)
+    bool        quiet;           // suppress per-entry output
+} ExtractConfig;
+
+// I/O call counters; on both targets each stdio call here maps to roughly one
+// filesystem request, so these approximate syscall counts.
+typedef struct {
+    u64 opens, closes, reads, writes, seeks, stats, mkdirs, renames, removes, syncs;
+    u64 bytesWritten;
+    u32 entries, failures, skipped, resumed;
+} ExtractStats;
+
+void extractConfigDefaults(ExtractConfig* cfg);
+
+// Read the whole manifest in one go. Returns a malloc'd buffer (caller frees) or NULL.
+u8* extractLoadManifest(const char* path, size_t* sizeOut, ExtractStats* stats);
+
+// Bounds-check the header once so entries can be walked without further parsing.
+const ManifestHeader* extractValidateManifest(const u8* data, size_t size);
+
+// Extract every entry. Returns the number of failed entries; stats may be NULL.
+u32 extractAll(const ExtractConfig* cfg, const u8* data, const ManifestHeader* hdr, ExtractStats* stats);
+
+const char* extractErrorString(int rc);
@@ -0,0 +1,47 @@
+// stub/include/manifest.h
+// Binary extraction manifest (romfs:/manifest.bin) written by packer/io/filelist.py.
+// All fields are little-endian; strings live in a NUL-terminated string table.
+#pragma once
+
+#include <stdint.h>
+
+#define MANIFEST_FILE        "manifest.bin"
+#define MANIFEST_MAGIC       "SRPM"
+#define MANIFEST_VERSION     2
+
+#define MANIFEST_CODEC_NONE  0
+
+#define MANIFEST_ENTRY_VERIFY_CRC 0x0001
+
+#define MANIFEST_NO_STRING   0xFFFFFFFFu
+
+typedef struct {
+    char     magic[4];
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t entry_count;
+    uint32_t entry_size;
+    uint32_t entries_offset;
+    uint32_t strtab_offset;
+    uint32_t strtab_size;
+    uint32_t flags;
+    // v2+: unique destination directories (u32 strtab offsets, parents first)
+    uint32_t dir_count;
+    uint32_t dirs_offset;
+} __attribute__((packed)) ManifestHeader;
+
+#define MANIFEST_HEADER_V1_SIZE 32
+
+typedef struct {
+    uint64_t size;
+    uint32_t crc32;
+    uint16_t codec;
+    uint16_t flags;
+    uint32_t src_off;       // RomFS-relative source path
+    uint32_t platform_off;  // platform folder under /roms/
+    uint32_t dest_off;      // absolute SD destination override, or MANIFEST_NO_STRING
+    uint32_t reserved[5];
+} __attribute__((packed)) ManifestEntry;
+
+_Static_assert(sizeof(ManifestHeader) == 40, "ManifestHeader layout");
+_Static_assert(sizeof(ManifestEntry)  == 48, "ManifestEntry layout");
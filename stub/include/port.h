@@ -0,0 +1,46 @@
+// stub/include/port.h
+// Thin platform layer so the extraction engine builds both against libnx and
+// on a Linux host (make host-bench). Only what extract.c needs lives here.
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __SWITCH__
+#include <switch.h>
+
+typedef Mutex  PortMutex;
+typedef Thread PortThread;
+
+#else
+#include <pthread.h>
+
+typedef uint8_t  u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int32_t  s32;
+typedef int64_t  s64;
+
+typedef pthread_mutex_t PortMutex;
+
+typedef struct {
+    pthread_t handle;
+    void    (*entry)(void*);
+    void*     arg;
+} PortThread;
+
+#endif
+
+void portMutexInit(PortMutex* m);
+void portMutexLock(PortMutex* m);
+void portMutexUnlock(PortMutex* m);
+
+// Start a thread running entry(arg), pinned to `core` when the platform allows
+// it. Returns false if no thread could be created.
+bool portThreadStart(PortThread* t, void (*entry)(void*), void* arg, int core);
+void portThreadJoin(PortThread* t);
+
+// zlib-compatible CRC32, chainable: crc = portCrc32(crc, buf, n).
+u32 portCrc32(u32 seed, const void* buf, size_t size);
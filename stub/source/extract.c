@@ -0,0 +1,563 @@
+// stub/source/extract.c
+// Manifest-driven extraction: directory preparation, resumable verified copies
+// and the small-file work queue. Portable C; see include/port.h.
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "extract.h"
+
+#define PART_SUFFIX     ".part"
+#define JOURNAL_SUFFIX  ".jnl"
+#define JOURNAL_MAGIC   "SRPJ"
+#define JOURNAL_VERSION 1
+
+typedef struct {
+    const ExtractConfig*  cfg;
+    const u8*             data;
+    const ManifestHeader* hdr;
+    ExtractStats*         stats;
+    bool                  dirsPrepared;  // every manifest directory exists
+
+    // Work queue: entry indices, largest first. order[0, largeCount) is
+    // streamed by the calling thread; the rest is shared with the workers.
+    u32*                  order;
+    u32                   count;
+    u32                   largeCount;
+    u32                   next;
+
+    PortMutex             lock;          // queue, failures and console output
+} ExtractContext;
+
+#define COUNT(ctx, field) __atomic_fetch_add(&(ctx)->stats->field, 1, __ATOMIC_RELAXED)
+#define ADD(ctx, field, n) __atomic_fetch_add(&(ctx)->stats->field, (n), __ATOMIC_RELAXED)
+
+// The console is not thread-safe; all extraction output goes through here.
+static void logLine(ExtractContext* ctx, const char* fmt, ...) {
+    if (ctx->cfg->quiet) return;
+    va_list ap;
+    va_start(ap, fmt);
+    portMutexLock(&ctx->lock);
+    vprintf(fmt, ap);
+    portMutexUnlock(&ctx->lock);
+    va_end(ap);
+}
+
+// ---- counted I/O ----
+
+static FILE* ioOpen(ExtractContext* ctx, const char* path, const char* mode) {
+    COUNT(ctx, opens);
+    return fopen(path, mode);
+}
+
+static int ioClose(ExtractContext* ctx, FILE* f) {
+    COUNT(ctx, closes);
+    return fclose(f);
+}
+
+static size_t ioRead(ExtractContext* ctx, void* buf, size_t n, FILE* f) {
+    COUNT(ctx, reads);
+    return fread(buf, 1, n, f);
+}
+
+static size_t ioWrite(ExtractContext* ctx, const void* buf, size_t n, FILE* f) {
+    COUNT(ctx, writes);
+    size_t w = fwrite(buf, 1, n, f);
+    ADD(ctx, bytesWritten, w);
+    return w;
+}
+
+static int ioSeek(ExtractContext* ctx, FILE* f, u64 off) {
+    COUNT(ctx, seeks);
+    return fseeko(f, (off_t)off, SEEK_SET);
+}
+
+static int ioStat(ExtractContext* ctx, const char* path, struct stat* st) {
+    COUNT(ctx, stats);
+    return stat(path, st);
+}
+
+static int ioMkdir(ExtractContext* ctx, const char* path) {
+    COUNT(ctx, mkdirs);
+    return mkdir(path, 0777);
+}
+
+static int ioRemove(ExtractContext* ctx, const char* path) {
+    COUNT(ctx, removes);
+    return remove(path);
+}
+
+static int ioRename(ExtractContext* ctx, const char* from, const char* to) {
+    COUNT(ctx, renames);
+    return rename(from, to);
+}
+
+static int ioSync(ExtractContext* ctx, FILE* f) {
+    COUNT(ctx, syncs);
+    if (fflush(f) != 0) return -1;
+    return fsync(fileno(f));
+}
+
+// ---- helpers ----
+
+static char* joinPath(const char* a, const char* b) {
+    size_t len = strlen(a) + strlen(b) + 1;
+    char* out = malloc(len);
+    if (out) snprintf(out, len, "%s%s", a, b);
+    return out;
+}
+
+static const char* baseName(const char* path) {
+    const char* slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+static const ManifestEntry* entryAt(const u8* data, const ManifestHeader* hdr, u32 i) {
+    return (const ManifestEntry*)(data + hdr->entries_offset + (size_t)i * hdr->entry_size);
+}
+
+static const char* manifestString(const u8* data, const ManifestHeader* hdr, u32 off) {
+    if (off == MANIFEST_NO_STRING || off >= hdr->strtab_size) return NULL;
+    return (const char*)data + hdr->strtab_offset + off;
+}
+
+static int mkpath(ExtractContext* ctx, char* path) {
+    // mkdir -p, in place (path is restored before returning)
+    if (!path[0]) return 0;
+    for (char *p = path + 1; *p; ++p) {
+        if (*p == '/') {
+            *p = '\0';
+            ioMkdir(ctx, path); // ignore EEXIST
+            *p = '/';
+        }
+    }
+    if (ioMkdir(ctx, path) != 0 && errno != EEXIST) {
+        return -1;
+    }
+    return 0;
+}
+
+// ---- manifest ----
+
+u8* extractLoadManifest(const char* path, size_t* sizeOut, ExtractStats* stats) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    u8* data = NULL;
+    long sz = -1;
+    if (fseek(f, 0, SEEK_END) == 0) sz = ftell(f);
+    if (sz >= MANIFEST_HEADER_V1_SIZE && fseek(f, 0, SEEK_SET) == 0) {
+        data = malloc((size_t)sz);
+        if (data && fread(data, 1, (size_t)sz, f) != (size_t)sz) { free(data); data = NULL; }
+    }
+    fclose(f);
+    if (stats) { stats->opens++; stats->reads++; stats->closes++; }
+    if (data) *sizeOut = (size_t)sz;
+    return data;
+}
+
+const ManifestHeader* extractValidateManifest(const u8* data, size_t size) {
+    const ManifestHeader* hdr = (const ManifestHeader*)data;
+    if (memcmp(hdr->magic, MANIFEST_MAGIC, 4) != 0) return NULL;
+    if (hdr->version == 0 || hdr->version > MANIFEST_VERSION) return NULL;
+    if (hdr->entry_size < sizeof(ManifestEntry)) return NULL;
+    if (hdr->version >= 2 && (hdr->header_size < sizeof(ManifestHeader) || size < sizeof(ManifestHeader))) return NULL;
+    u64 entriesEnd = (u64)hdr->entries_offset + (u64)hdr->entry_count * hdr->entry_size;
+    u64 strtabEnd  = (u64)hdr->strtab_offset + hdr->strtab_size;
+    u64 dirsEnd    = hdr->version >= 2 ? (u64)hdr->dirs_offset + (u64)hdr->dir_count * sizeof(u32) : 0;
+    if (entriesEnd > size || strtabEnd > size || dirsEnd > size) return NULL;
+    // Last string must be terminated so every in-range offset yields a C string.
+    if (hdr->strtab_size && data[strtabEnd - 1] != '\0') return NULL;
+    return hdr;
+}
+
+// Create every directory listed in a v2 manifest exactly once. Leaves are
+// probed first: an existing leaf proves all of its prefixes exist, so on a
+// typical re-run this is one stat per leaf and no mkdir at all.
+static void prepareDirectories(ExtractContext* ctx) {
+    const u8* data = ctx->data;
+    const ManifestHeader* hdr = ctx->hdr;
+    if (hdr->version < 2 || hdr->dir_count == 0) return;
+
+    u32 n = hdr->dir_count;
+    const u32* offs = (const u32*)(data + hdr->dirs_offset);
+    char** dirs = calloc(n, sizeof(char*));
+    bool* present = calloc(n, sizeof(bool));
+    bool ok = dirs && present;
+    for (u32 i = 0; ok && i < n; i++) {
+        const char* d = manifestString(data, hdr, offs[i]);
+        dirs[i] = d ? joinPath(ctx->cfg->sdRoot, d) : NULL;
+        ok = dirs[i] != NULL;  // else fall back to mkpath
+    }
+
+    // Deepest first (the list is ordered parents first).
+    for (u32 i = n; ok && i-- > 0;) {
+        if (present[i]) continue;
+        struct stat st;
+        if (ioStat(ctx, dirs[i], &st) != 0 || !S_ISDIR(st.st_mode)) continue;
+        present[i] = true;
+        for (u32 j = 0; j < i; j++) {
+            size_t len = strlen(dirs[j]);
+            if (strncmp(dirs[i], dirs[j], len) == 0 && dirs[i][len] == '/') present[j] = true;
+        }
+    }
+
+    for (u32 i = 0; ok && i < n; i++) {
+        if (present[i]) continue;
+        if (ioMkdir(ctx, dirs[i]) != 0 && errno != EEXIST) {
+            logLine(ctx, "mkdir failed: %s\n", dirs[i]);
+            ok = false;
+        }
+    }
+    ctx->dirsPrepared = ok;
+    for (u32 i = 0; dirs && i < n; i++) free(dirs[i]);
+    free(dirs);
+    free(present);
+}
+
+// ---- resumable extraction ----
+// Data is written to "<dst>.part"; for entries larger than one journalChunk,
+// every journalChunk bytes the part file is flushed and "<dst>.part.jnl"
+// records the committed offset plus the running CRC. The part file is renamed
+// over <dst> only after the full CRC has been verified. On resume the
+// committed bytes are read back and must match the journal's CRC.
+
+typedef struct {
+    char magic[4];
+    u32  version;
+    u64  size;          // expected payload size (manifest)
+    u32  crc32;         // expected payload CRC (manifest)
+    u32  running_crc;   // CRC of bytes [0, committed)
+    u64  committed;     // bytes durably written to the part file
+} __attribute__((packed)) ExtractJournal;
+
+static bool readJournal(ExtractContext* ctx, const char* path, const ManifestEntry* e, ExtractJournal* out) {
+    FILE* f = ioOpen(ctx, path, "rb");
+    if (!f) return false;
+    bool ok = ioRead(ctx, out, sizeof(*out), f) == sizeof(*out);
+    ioClose(ctx, f);
+    return ok
+        && memcmp(out->magic, JOURNAL_MAGIC, 4) == 0
+        && out->version == JOURNAL_VERSION
+        && out->size == e->size
+        && out->crc32 == e->crc32
+        && out->committed <= e->size;
+}
+
+static bool writeJournal(ExtractContext* ctx, const char* path, const ManifestEntry* e, u32 runningCrc, u64 committed) {
+    ExtractJournal j;
+    memcpy(j.magic, JOURNAL_MAGIC, 4);
+    j.version     = JOURNAL_VERSION;
+    j.size        = e->size;
+    j.crc32       = e->crc32;
+    j.running_crc = runningCrc;
+    j.committed   = committed;
+    FILE* f = ioOpen(ctx, path, "wb");
+    if (!f) return false;
+    bool ok = ioWrite(ctx, &j, sizeof(j), f) == sizeof(j) && ioSync(ctx, f) == 0;
+    ok = (ioClose(ctx, f) == 0) && ok;
+    return ok;
+}
+
+// A journal that could not be written must not be trusted by the next run:
+// drop it and finish this entry without one.
+static bool commitJournal(ExtractContext* ctx, const char* path, const ManifestEntry* e, u32 runningCrc, u64 committed) {
+    if (writeJournal(ctx, path, e, runningCrc, committed)) return true;
+    logLine(ctx, "Journal write failed, resume disabled: %s\n", path);
+    ioRemove(ctx, path);
+    return false;
+}
+
+// CRC of the first `size` bytes of f (read from the current position), or
+// false on a short read.
+static bool crcPrefix(ExtractContext* ctx, FILE* f, u64 size, char* buf, u32* crc) {
+    *crc = 0;
+    for (u64 left = size; left;) {
+        size_t want = left < ctx->cfg->bufferSize ? (size_t)left : ctx->cfg->bufferSize;
+        size_t n = ioRead(ctx, buf, want, f);
+        if (n == 0) return false;
+        *crc = portCrc32(*crc, buf, n);
+        left -= n;
+    }
+    return true;
+}
+
+// An existing destination counts as this entry only if its size and CRC
+// match: it may be a hand-copied file, an older stub's output or another
+// revision of the same size.
+static bool destMatches(ExtractContext* ctx, const char* dstPath, const struct stat* st, const ManifestEntry* e, char* buf) {
+    if ((u64)st->st_size != e->size || !(e->flags & MANIFEST_ENTRY_VERIFY_CRC) || !buf) return false;
+    FILE* f = ioOpen(ctx, dstPath, "rb");
+    if (!f) return false;
+    u32 crc;
+    bool ok = crcPrefix(ctx, f, e->size, buf, &crc) && crc == e->crc32;
+    ioClose(ctx, f);
+    return ok;
+}
+
+// buf is the calling thread's copy buffer (cfg->bufferSize bytes), reused
+// across entries so a disc set's tracks stream without per-file allocations.
+static int extractFile(ExtractContext* ctx, const char* srcPath, const char* dstPath, const ManifestEntry* e, char* buf) {
+    struct stat st;
+    bool dstExists = ioStat(ctx, dstPath, &st) == 0;
+    if (dstExists && destMatches(ctx, dstPath, &st, e, buf)) {
+        logLine(ctx, "Already extracted: %s\n", dstPath);
+        __atomic_fetch_add(&ctx->stats->skipped, 1, __ATOMIC_RELAXED);
+        return EXTRACT_OK;
+    }
+
+    FILE* src = ioOpen(ctx, srcPath, "rb");
+    if (!src) return EXTRACT_ERR_NOT_FOUND;
+
+    // Ensure destination directory exists (v1 manifests carry no directory list)
+    char* dir = ctx->dirsPrepared ? NULL : strdup(dstPath);
+    if (dir) {
+        char *lastSlash = strrchr(dir, '/');
+        if (lastSlash) { *lastSlash = '\0'; mkpath(ctx, dir); }
+        free(dir);
+    }
+
+    int rc = EXTRACT_OK;
+    size_t bufSize    = ctx->cfg->bufferSize;
+    char* partPath    = joinPath(dstPath, PART_SUFFIX);
+    char* journalPath = joinPath(dstPath, PART_SUFFIX JOURNAL_SUFFIX);
+    FILE* dst         = NULL;
+    if (!partPath || !journalPath || !buf) {
+        rc = EXTRACT_ERR_NO_MEMORY;
+        goto out;
+    }
+
+    // Entries that fit in one journal chunk are cheaper to redo than to journal.
+    bool journaled = e->size > ctx->cfg->journalChunk;
+
+    // Resume from the last committed chunk if the journal matches this entry
+    // and the part file still holds the bytes it vouches for. crc always
+    // covers bytes actually read back or written, never the journal's word.
+    u32 crc = 0;
+    u64 done = 0;
+    ExtractJournal j;
+    if (journaled && readJournal(ctx, journalPath, e, &j) && (dst = ioOpen(ctx, partPath, "r+b")) != NULL) {
+        u32 partCrc;
+        if (crcPrefix(ctx, dst, j.committed, buf, &partCrc) && partCrc == j.running_crc
+            && ftruncate(fileno(dst), (off_t)j.committed) == 0
+            && ioSeek(ctx, dst, j.committed) == 0
+            && ioSeek(ctx, src, j.committed) == 0) {
+            crc  = partCrc;
+            done = j.committed;
+            __atomic_fetch_add(&ctx->stats->resumed, 1, __ATOMIC_RELAXED);
+            logLine(ctx, "Resuming %s at %llu / %llu bytes.\n",
+                    dstPath, (unsigned long long)done, (unsigned long long)e->size);
+        } else {
+            logLine(ctx, "Part file does not match its journal, restarting: %s\n", dstPath);
+            ioClose(ctx, dst);
+            dst = NULL;
+        }
+    }
+    if (!dst) {
+        ioSeek(ctx, src, 0);
+        dst = ioOpen(ctx, partPath, "wb");
+        if (!dst) { rc = EXTRACT_ERR_IO; goto out; }
+        if (journaled) journaled = commitJournal(ctx, journalPath, e, 0, 0);
+    }
+
+    u64 sinceCommit = 0;
+    size_t n;
+    while ((n = ioRead(ctx, buf, bufSize, src)) > 0) {
+        crc = portCrc32(crc, buf, n);
+        if (ioWrite(ctx, buf, n, dst) != n) {
+            rc = EXTRACT_ERR_IO;
+            goto out;
+        }
+        done += n;
+        sinceCommit += n;
+        if (journaled && sinceCommit >= ctx->cfg->journalChunk) {
+            // Data first, then the journal that vouches for it.
+            if (ioSync(ctx, dst) != 0) {
+                rc = EXTRACT_ERR_IO;
+                goto out;
+            }
+            journaled = commitJournal(ctx, journalPath, e, crc, done);
+            sinceCommit = 0;
+        }
+    }
+    if (ioClose(ctx, dst) != 0) { dst = NULL; rc = EXTRACT_ERR_IO; goto out; }
+    dst = NULL;
+
+    if (done != e->size || ((e->flags & MANIFEST_ENTRY_VERIFY_CRC) && crc != e->crc32)) {
+        logLine(ctx, "Verify failed for %s: %llu bytes crc %08x, expected %llu bytes crc %08x\n",
+                dstPath, (unsigned long long)done, crc, (unsigned long long)e->size, e->crc32);
+        ioRemove(ctx, partPath);
+        if (journaled) ioRemove(ctx, journalPath);
+        rc = EXTRACT_ERR_IO;
+        goto out;
+    }
+
+    // rename() does not replace on every fsdev backend
+    if (dstExists) ioRemove(ctx, dstPath);
+    if (ioRename(ctx, partPath, dstPath) != 0) {
+        rc = EXTRACT_ERR_IO;
+        goto out;
+    }
+    if (journaled) ioRemove(ctx, journalPath);
+
+out:
+    if (dst) ioClose(ctx, dst);
+    ioClose(ctx, src);
+    free(partPath);
+    free(journalPath);
+    return rc;
+}
+
+static int extractEntry(ExtractContext* ctx, const ManifestEntry* e, char* buf) {
+    const char* src      = manifestString(ctx->data, ctx->hdr, e->src_off);
+    const char* platform = manifestString(ctx->data, ctx->hdr, e->platform_off);
+    const char* dest     = manifestString(ctx->data, ctx->hdr, e->dest_off);
+    if (!src || (!dest && !platform)) {
+        logLine(ctx, "Bad manifest entry.\n");
+        return EXTRACT_ERR_BAD_INPUT;
+    }
+    if (e->codec != MANIFEST_CODEC_NONE) {
+        logLine(ctx, "Unsupported codec %u for %s\n", e->codec, src);
+        return EXTRACT_ERR_BAD_INPUT;
+    }
+
+    // Sized from the actual strings, so long names are never truncated.
+    const char* sdRoot = ctx->cfg->sdRoot;
+    size_t srcLen = strlen(ctx->cfg->romfsRoot) + strlen(src) + 1;
+    size_t dstLen = strlen(sdRoot) + (dest ? strlen(dest)
+                  : strlen(EXTRACT_OUTPUT_BASE) + strlen(platform) + 1 + strlen(baseName(src))) + 1;
+    char* srcPath = malloc(srcLen);
+    char* dstPath = malloc(dstLen);
+    if (!srcPath || !dstPath) {
+        free(srcPath); free(dstPath);
+        return EXTRACT_ERR_NO_MEMORY;
+    }
+    snprintf(srcPath, srcLen, "%s%s", ctx->cfg->romfsRoot, src);
+    if (dest) snprintf(dstPath, dstLen, "%s%s", sdRoot, dest);
+    else      snprintf(dstPath, dstLen, "%s" EXTRACT_OUTPUT_BASE "%s/%s", sdRoot, platform, baseName(src));
+
+    logLine(ctx, "Copying %s -> %s\n", srcPath, dstPath);
+    int rc = extractFile(ctx, srcPath, dstPath, e, buf);
+    if (rc != EXTRACT_OK) logLine(ctx, "  Copy failed (%s): %s\n", extractErrorString(rc), dstPath);
+    else                  logLine(ctx, "  Done: %s\n", dstPath);
+
+    free(srcPath);
+    free(dstPath);
+    return rc;
+}
+
+// ---- concurrent extraction ----
+// Entries are ordered largest first. The large prefix is streamed sequentially
+// by the calling thread; the small tail is a shared queue drained by up to
+// maxWorkers threads (and by the caller once it runs out of large files).
+
+static void runEntry(ExtractContext* ctx, u32 idx, char* buf) {
+    __atomic_fetch_add(&ctx->stats->entries, 1, __ATOMIC_RELAXED);
+    if (extractEntry(ctx, entryAt(ctx->data, ctx->hdr, idx), buf) != EXTRACT_OK)
+        __atomic_fetch_add(&ctx->stats->failures, 1, __ATOMIC_RELAXED);
+}
+
+static void drainSmall(ExtractContext* ctx, char* buf) {
+    for (;;) {
+        portMutexLock(&ctx->lock);
+        u32 slot = ctx->next < ctx->count ? ctx->next++ : ctx->count;
+        portMutexUnlock(&ctx->lock);
+        if (slot >= ctx->count) return;
+        runEntry(ctx, ctx->order[slot], buf);
+    }
+}
+
+static void workerMain(void* arg) {
+    // Without a buffer this worker just leaves the queue to the others.
+    char* buf = malloc(((ExtractContext*)arg)->cfg->bufferSize);
+    if (buf) drainSmall((ExtractContext*)arg, buf);
+    free(buf);
+}
+
+typedef struct {
+    u64 size;
+    u32 index;
+} SortKey;
+
+static int cmpBySizeDesc(const void* a, const void* b) {
+    u64 sa = ((const SortKey*)a)->size;
+    u64 sb = ((const SortKey*)b)->size;
+    return sa < sb ? 1 : sa > sb ? -1 : 0;
+}
+
+void extractConfigDefaults(ExtractConfig* cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->romfsRoot       = "romfs:/";
+    cfg->sdRoot          = "";
+    cfg->bufferSize      = EXTRACT_DEFAULT_BUFSZ;
+    cfg->largeEntryBytes = EXTRACT_DEFAULT_LARGE_BYTES;
+    cfg->journalChunk    = EXTRACT_DEFAULT_JOURNAL;
+    cfg->maxWorkers      = EXTRACT_MAX_WORKERS;
+}
+
+u32 extractAll(const ExtractConfig* cfg, const u8* data, const ManifestHeader* hdr, ExtractStats* stats) {
+    ExtractStats scratch;
+    if (!stats) { memset(&scratch, 0, sizeof(scratch)); stats = &scratch; }
+    u32 failuresBefore = stats->failures;
+
+    ExtractContext ctx = { .cfg = cfg, .data = data, .hdr = hdr, .stats = stats, .count = hdr->entry_count };
+    portMutexInit(&ctx.lock);
+    prepareDirectories(&ctx);
+
+    // One copy buffer for every entry this thread extracts; runEntry reports
+    // each entry as out of memory if it could not be allocated.
+    char* buf = malloc(cfg->bufferSize);
+
+    SortKey* keys = malloc(sizeof(SortKey) * (ctx.count ? ctx.count : 1));
+    ctx.order     = malloc(sizeof(u32) * (ctx.count ? ctx.count : 1));
+    if (!keys || !ctx.order) {
+        // Fall back to manifest order without the queue.
+        free(keys);
+        free(ctx.order);
+        for (u32 i = 0; i < hdr->entry_count; i++) runEntry(&ctx, i, buf);
+        free(buf);
+        return stats->failures - failuresBefore;
+    }
+    for (u32 i = 0; i < ctx.count; i++) keys[i] = (SortKey){ entryAt(data, hdr, i)->size, i };
+    qsort(keys, ctx.count, sizeof(SortKey), cmpBySizeDesc);
+    for (u32 i = 0; i < ctx.count; i++) ctx.order[i] = keys[i].index;
+    while (ctx.largeCount < ctx.count && keys[ctx.largeCount].size >= cfg->largeEntryBytes)
+        ctx.largeCount++;
+    free(keys);
+    ctx.next = ctx.largeCount;
+
+    // Only spin up workers when there are small entries for them to share.
+    u32 smallCount = ctx.count - ctx.largeCount;
+    u32 maxWorkers = cfg->maxWorkers < EXTRACT_MAX_WORKERS ? cfg->maxWorkers : EXTRACT_MAX_WORKERS;
+    u32 wanted = smallCount > 1 ? (smallCount < maxWorkers ? smallCount : maxWorkers) : 0;
+
+    PortThread workers[EXTRACT_MAX_WORKERS];
+    u32 started = 0;
+    for (u32 i = 0; i < wanted; i++) {
+        if (!portThreadStart(&workers[started], workerMain, &ctx, EXTRACT_FIRST_WORKER_CORE + (int)i)) break;
+        started++;
+    }
+
+    for (u32 i = 0; i < ctx.largeCount; i++) runEntry(&ctx, ctx.order[i], buf);
+    drainSmall(&ctx, buf);
+
+    for (u32 i = 0; i < started; i++) portThreadJoin(&workers[i]);
+    free(ctx.order);
+    free(buf);
+    return stats->failures - failuresBefore;
+}
+
+const char* extractErrorString(int rc) {
+    switch (rc) {
+        case EXTRACT_OK:            return "ok";
+        case EXTRACT_ERR_NOT_FOUND: return "source not found";
+        case EXTRACT_ERR_IO:        return "I/O error";
+        case EXTRACT_ERR_BAD_INPUT: return "bad manifest entry";
+        case EXTRACT_ERR_NO_MEMORY: return "out of memory";
+        default:                    return "unknown error";
+    }
+}
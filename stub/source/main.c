@@ -1,105 +1,65 @@
 #include <stdio.h>
-#include <string.h>
-#include <sys/stat.h>
-#include <errno.h>
+#include <stdlib.h>
 #include <switch.h>
 
-#define OUTPUT_BASE "/roms/"
-#define FILELIST    "filelist.txt"   // lines: "<platform>\t<filename>"
+#include "boottrace.h"
+#include "extract.h"
 
-static int mkpath(const char* path) {
-    // mkdir -p
-    char tmp[1024];
-    size_t len = strnlen(path, sizeof(tmp) - 1);
-    if (len == 0) return 0;
-    memcpy(tmp, path, len);
-    tmp[len] = '\0';
+#ifndef SRP_TRACE
+#define SRP_TRACE 0
+#endif
 
-    for (char *p = tmp + 1; *p; ++p) {
-        if (*p == '/') {
-            *p = '\0';
-            mkdir(tmp, 0777); // ignore EEXIST
-            *p = '/';
-        }
-    }
-    if (mkdir(tmp, 0777) != 0 && errno != EEXIST) {
-        return -1;
-    }
-    return 0;
-}
-
-static Result copyFile(const char* srcPath, const char* dstPath) {
-    FILE* src = fopen(srcPath, "rb");
-    if (!src) return MAKERESULT(Module_Libnx, LibnxError_NotFound);
-
-    // Ensure destination directory exists
-    char dir[1024];
-    strncpy(dir, dstPath, sizeof(dir));
-    dir[sizeof(dir)-1] = '\0';
-    char *lastSlash = strrchr(dir, '/');
-    if (lastSlash) { *lastSlash = '\0'; mkpath(dir); }
-
-    FILE* dst = fopen(dstPath, "wb");
-    if (!dst) { fclose(src); return MAKERESULT(Module_Libnx, LibnxError_IoError); }
-
-    char buf[8192];
-    size_t n;
-    while ((n = fread(buf, 1, sizeof(buf), src)) > 0) {
-        if (fwrite(buf, 1, n, dst) != n) {
-            fclose(src); fclose(dst);
-            return MAKERESULT(Module_Libnx, LibnxError_IoError);
-        }
-    }
-    fclose(src); fclose(dst);
-    return 0;
-}
+// BootTraceRecord.status values; partial extraction reports the failure count.
+#define STUB_ERR_ROMFS        0x80000001u
+#define STUB_ERR_NO_MANIFEST  0x80000002u
+#define STUB_ERR_BAD_MANIFEST 0x80000003u
 
 int main(int argc, char* argv[])
 {
+    BootTrace trace;
+    bootTraceBegin(&trace, BOOTTRACE_STUB);
+    u32 status = 0;
+
     consoleInit(NULL);
+    bootTraceMark(&trace, STUB_STAGE_CONSOLE_INIT);
 
     Result rc = romfsInit();
+    bootTraceMark(&trace, STUB_STAGE_ROMFS_INIT);
     if (R_FAILED(rc)) {
         printf("romfsInit failed: 0x%x\n", rc);
+        status = STUB_ERR_ROMFS;
     } else {
-        char listPath[128];
-        snprintf(listPath, sizeof(listPath), "romfs:/%s", FILELIST);
-
-        FILE* list = fopen(listPath, "r");
-        if (!list) {
-            printf("Missing %s in RomFS.\n", FILELIST);
+        ExtractConfig cfg;
+        extractConfigDefaults(&cfg);
+
+        size_t size = 0;
+        u8* data = extractLoadManifest("romfs:/" MANIFEST_FILE, &size, NULL);
+        bootTraceMark(&trace, STUB_STAGE_LOAD);
+        const ManifestHeader* hdr = data ? extractValidateManifest(data, size) : NULL;
+        if (!data) {
+            printf("Missing %s in RomFS.\n", MANIFEST_FILE);
+            status = STUB_ERR_NO_MANIFEST;
+        } else if (!hdr) {
+            bootTraceMark(&trace, STUB_STAGE_VALIDATE);
+            printf("Invalid or unsupported %s.\n", MANIFEST_FILE);
+            status = STUB_ERR_BAD_MANIFEST;
         } else {
-            char line[768];
-            while (fgets(line, sizeof(line), list)) {
-                // Trim CR/LF
-                size_t len = strlen(line);
-                while (len && (line[len-1] == '\n' || line[len-1] == '\r')) line[--len] = '\0';
-                if (!len) continue;
-
-                // Parse "<platform>\t<filename>"
-                char platform[160] = {0};
-                char filename[576] = {0};
-                if (sscanf(line, "%159[^\t]\t%575[^\n]", platform, filename) != 2) {
-                    printf("Bad manifest line: %s\n", line);
-                    continue;
-                }
-
-                char srcPath[700];
-                char dstPath[1100];
-
-                snprintf(srcPath, sizeof(srcPath), "romfs:/%s", filename);
-                snprintf(dstPath, sizeof(dstPath), OUTPUT_BASE "%s/%s", platform, filename);
-
-                printf("Copying %s -> %s\n", srcPath, dstPath);
-                rc = copyFile(srcPath, dstPath);
-                if (R_FAILED(rc)) printf("  Copy failed: 0x%x\n", rc);
-                else              printf("  Done.\n");
-            }
-            fclose(list);
+            bootTraceMark(&trace, STUB_STAGE_VALIDATE);
+            u32 failures = extractAll(&cfg, data, hdr, NULL);
+            bootTraceMark(&trace, STUB_STAGE_EXTRACT);
+            printf("%u of %u entries extracted.\n", hdr->entry_count - failures, hdr->entry_count);
+            status = failures;
         }
+        free(data);
         romfsExit();
     }
 
+    char timing[160];
+    trace.rec.status = status;
+    bootTraceFormat(&trace, timing, sizeof(timing));
+    printf("%s\n", timing);
+    if (SRP_TRACE) bootTraceWrite(&trace);
+
     // PadState input loop (libnx 4.9.0+)
     PadState pad;
     padConfigureInput(1, HidNpadStyleSet_NpadStandard);
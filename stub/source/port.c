@@ -0,0 +1,80 @@
+// stub/source/port.c
+// libnx and POSIX implementations of include/port.h.
+#include "port.h"
+
+#ifdef __SWITCH__
+
+#define WORKER_STACK_SIZE 0x10000
+
+void portMutexInit(PortMutex* m)   { mutexInit(m); }
+void portMutexLock(PortMutex* m)   { mutexLock(m); }
+void portMutexUnlock(PortMutex* m) { mutexUnlock(m); }
+
+bool portThreadStart(PortThread* t, void (*entry)(void*), void* arg, int core) {
+    s32 prio = 0x2C;
+    svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
+    // Pin to the requested core when permitted, else let the kernel pick.
+    if (R_FAILED(threadCreate(t, entry, arg, NULL, WORKER_STACK_SIZE, prio, core))
+        && R_FAILED(threadCreate(t, entry, arg, NULL, WORKER_STACK_SIZE, prio, -2)))
+        return false;
+    if (R_FAILED(threadStart(t))) {
+        threadClose(t);
+        return false;
+    }
+    return true;
+}
+
+void portThreadJoin(PortThread* t) {
+    threadWaitForExit(t);
+    threadClose(t);
+}
+
+u32 portCrc32(u32 seed, const void* buf, size_t size) {
+    return crc32CalculateWithSeed(seed, buf, size);
+}
+
+#else
+
+void portMutexInit(PortMutex* m)   { pthread_mutex_init(m, NULL); }
+void portMutexLock(PortMutex* m)   { pthread_mutex_lock(m); }
+void portMutexUnlock(PortMutex* m) { pthread_mutex_unlock(m); }
+
+static void* threadTrampoline(void* p) {
+    PortThread* t = p;
+    t->entry(t->arg);
+    return NULL;
+}
+
+bool portThreadStart(PortThread* t, void (*entry)(void*), void* arg, int core) {
+    (void)core;  // the host scheduler spreads threads on its own
+    t->entry = entry;
+    t->arg   = arg;
+    return pthread_create(&t->handle, NULL, threadTrampoline, t) == 0;
+}
+
+void portThreadJoin(PortThread* t) {
+    pthread_join(t->handle, NULL);
+}
+
+// Table-driven CRC32 (reflected, poly 0xEDB88320), matching zlib and
+// libnx crc32CalculateWithSeed.
+static u32            g_crcTable[256];
+static pthread_once_t g_crcOnce = PTHREAD_ONCE_INIT;
+
+static void crcInit(void) {
+    for (u32 i = 0; i < 256; i++) {
+        u32 c = i;
+        for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        g_crcTable[i] = c;
+    }
+}
+
+u32 portCrc32(u32 seed, const void* buf, size_t size) {
+    pthread_once(&g_crcOnce, crcInit);
+    const u8* p = buf;
+    u32 crc = ~seed;
+    while (size--) crc = g_crcTable[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+#endif
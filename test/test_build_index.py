@@ -0,0 +1,28 @@
+from packer.build.index import BuildIndex, BuildRecord
+from packer.build.playlist import PlaylistEntry
+
+GB = "Nintendo - Game Boy"
+
+
+def _record(*outputs):
+    return BuildRecord(GB, "T", 1, 2, list(outputs), PlaylistEntry(GB, f"/roms/{GB}/t.gb", "T", 7))
+
+
+def test_replace_and_drop_remove_only_unclaimed_outputs(tmp_path):
+    for name in ("nro/A.nro", "nro/B.nro", "nsp/A [0100000000001000].nsp"):
+        (tmp_path / name).parent.mkdir(parents=True, exist_ok=True)
+        (tmp_path / name).write_bytes(b"x")
+
+    index = BuildIndex(tmp_path)
+    index.replace("/roms/a.gb", _record("nro/A.nro", "nsp/A [0100000000001000].nsp"))
+    index.replace("/roms/a2.gb", _record("nro/A.nro"))          # same title, same NRO name
+    index.replace("/roms/a.gb", _record("nro/B.nro"))            # renamed title
+    assert not (tmp_path / "nsp/A [0100000000001000].nsp").exists()
+    assert (tmp_path / "nro/A.nro").exists()                     # still claimed by a2
+
+    index.save()
+    index = BuildIndex.load(tmp_path)
+    assert index.records["/roms/a.gb"].playlist.crc32 == 7
+    index.drop("/roms/a2.gb")
+    assert not (tmp_path / "nro/A.nro").exists()
+    assert (tmp_path / "nro/B.nro").exists()
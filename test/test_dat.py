@@ -0,0 +1,34 @@
+from packer.metadata.dat import DatIndex
+
+DAT = """<?xml version="1.0"?>
+<!DOCTYPE datafile PUBLIC "-//Logiqx//DTD ROM Management Datafile//EN" "http://www.logiqx.com/dtds/datafile.dtd">
+<datafile>
+  <header>
+    <name>Nintendo - Game Boy</name>
+    <description>Nintendo - Game Boy</description>
+  </header>
+  <game name="Tetris (World) (Rev 1)">
+    <description>Tetris (World) (Rev 1)</description>
+    <rom name="Tetris (World) (Rev 1).gb" size="32768" crc="46df91ad" sha1="74591cc9501af93873f9a5d3eb12da12c0723bbc"/>
+  </game>
+  <game name="Pokemon - Red Version (USA, Europe) (SGB Enhanced)">
+    <rom name="Pokemon - Red Version (USA, Europe) (SGB Enhanced).gb" size="1048576" crc="9f7fdd53"/>
+  </game>
+</datafile>
+"""
+
+
+def test_import_and_lookup(tmp_path):
+    dat = tmp_path / "gb.dat"
+    dat.write_text(DAT)
+    index = DatIndex(tmp_path / "dat.sqlite")
+    assert index.import_dat(dat) == 2
+    assert index.import_dat(dat) == 0          # unchanged: not re-imported
+
+    m = index.lookup(0x12345678, sha1="74591CC9501AF93873F9A5D3EB12DA12C0723BBC")
+    assert m.game == "Tetris (World) (Rev 1)" and m.system == "Nintendo - Game Boy"
+    assert index.lookup(0x9F7FDD53, size=1048576).thumbnail_name == (
+        "Pokemon - Red Version (USA, Europe) (SGB Enhanced)"
+    )
+    assert index.lookup(0x9F7FDD53, size=4) is None
+    assert index.lookup(0xDEADBEEF) is None
@@ -0,0 +1,56 @@
+import zipfile
+from pathlib import Path
+
+import pytest
+
+from packer.build.dedup import find_duplicates, parse_rules
+
+GB = "Nintendo - Game Boy"
+GBC = "Nintendo - Game Boy Color"
+
+
+def _item(platform, path):
+    return {"platform": platform, "rom_path": Path(path)}
+
+
+def test_identical_payloads_are_built_once():
+    items = [
+        _item(GB, "/r/gb/Tetris (World).gb"),
+        _item(GB, "/r/gb/copies/tetris.gb"),
+        _item(GBC, "/r/gbc/Tetris.gb"),
+        _item(GB, "/r/gb/Other.gb"),
+        _item(GB, "/r/gb/Unhashed.gb"),
+    ]
+    keys = {"Other.gb": ("b", 10), "Unhashed.gb": None}
+
+    keep, groups = find_duplicates(
+        items, lambda it: keys.get(it["rom_path"].name, ("a", 100)), parse_rules("tagged,shallow"), Path("/r")
+    )
+    assert [it["rom_path"].name for it in keep] == ["Tetris (World).gb", "Other.gb", "Unhashed.gb"]
+    assert len(groups) == 1
+    assert [d["rom_path"].name for d in groups[0].duplicates] == ["Tetris.gb", "tetris.gb"]
+    assert groups[0].bytes_saved == 200
+
+
+def test_header_rule_reads_zipped_copies(tmp_path):
+    from packer.discovery.systems import _GB_LOGO
+
+    rom = bytearray(0x150)
+    rom[0x104:0x104 + len(_GB_LOGO)] = _GB_LOGO        # DMG-only: CGB flag 0
+    (tmp_path / "gbc").mkdir()
+    (tmp_path / "zipped").mkdir()       # sorts after gbc, so only the header rule can pick it
+    loose = tmp_path / "gbc" / "Tetris.gb"
+    loose.write_bytes(rom)
+    with zipfile.ZipFile(tmp_path / "zipped" / "Tetris.zip", "w", zipfile.ZIP_DEFLATED) as z:
+        z.writestr("Tetris.gb", bytes(rom))
+    zipped = tmp_path / "zipped" / "Tetris.zip" / "Tetris.gb"
+
+    keep, _ = find_duplicates(
+        [_item(GBC, loose), _item(GB, zipped)], lambda it: ("a", 1), parse_rules("header,name"), tmp_path
+    )
+    assert [it["rom_path"] for it in keep] == [zipped]
+
+
+def test_unknown_rule_is_rejected():
+    with pytest.raises(ValueError):
+        parse_rules("tagged,biggest")
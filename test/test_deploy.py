@@ -0,0 +1,65 @@
+import zipfile
+
+import pytest
+
+from packer.io.deploy import DeployItem, check_destinations, deploy, plan_roms, rom_sd_name
+
+
+def test_deploy_copies_only_changes_and_removes_orphans(tmp_path):
+    src, sd = tmp_path / "out", tmp_path / "sd"
+    src.mkdir()
+    sd.mkdir()
+    a, b = src / "a.nro", src / "b.nsp"
+    a.write_bytes(b"A" * 1000)
+    b.write_bytes(b"B" * 10)
+    items = [DeployItem(a, "switch/x/a.nro"), DeployItem(b, "nsp/b.nsp")]
+
+    first = deploy(items, sd, jobs=2)
+    assert (first.copied, first.unchanged) == (2, 0)
+    assert (sd / "switch/x/a.nro").read_bytes() == b"A" * 1000
+
+    again = deploy(items, sd)
+    assert (again.copied, again.unchanged) == (0, 2)
+
+    a.write_bytes(b"C" * 1000)
+    (sd / "unrelated.txt").write_text("mine")
+    third = deploy(items[:1], sd)
+    assert (third.copied, third.deleted) == (1, 1)
+    assert (sd / "switch/x/a.nro").read_bytes() == b"C" * 1000
+    assert not (sd / "nsp/b.nsp").exists()
+    assert (sd / "unrelated.txt").exists()
+    assert not list(sd.rglob("*.deploy-tmp"))
+
+
+def test_nested_roms_keep_their_subfolder(tmp_path):
+    root = tmp_path / "roms"
+    (root / "gb" / "USA").mkdir(parents=True)
+    top, nested = root / "gb" / "Tetris.gb", root / "gb" / "USA" / "Tetris.gb"
+    top.write_bytes(b"A")
+    nested.write_bytes(b"B")
+    with zipfile.ZipFile(root / "gb" / "USA" / "Mario.zip", "w") as z:
+        z.writestr("Mario.gb", b"M")
+    member = root / "gb" / "USA" / "Mario.zip" / "Mario.gb"
+
+    assert rom_sd_name(root, top) == "Tetris.gb"
+    assert rom_sd_name(root, nested) == "USA/Tetris.gb"
+    assert rom_sd_name(root, member) == "USA/Mario.gb"
+    assert rom_sd_name(root, tmp_path / "Flat.gb") == "Flat.gb"
+    dests = [i.dest for i in plan_roms([("gb", top), ("gb", nested)], root)]
+    assert dests == ["roms/gb/Tetris.gb", "roms/gb/USA/Tetris.gb"]
+
+    check_destinations([("roms/gb/Tetris.gb", top), ("roms/gb/USA/Tetris.gb", nested)])
+    with pytest.raises(SystemExit, match="overwrite each other"):
+        check_destinations([("roms/gb/Tetris.gb", top), ("roms/gb/tetris.gb", nested)])
+
+
+def test_deploy_refuses_two_sources_for_one_path(tmp_path):
+    a, b = tmp_path / "a" / "Tetris.gb", tmp_path / "b" / "Tetris.gb"
+    for p in (a, b):
+        p.parent.mkdir()
+        p.write_bytes(p.parent.name.encode())
+    sd = tmp_path / "sd"
+    sd.mkdir()
+    with pytest.raises(SystemExit, match=r"\[deploy\].*overwrite each other"):
+        deploy([DeployItem(a, "roms/gb/Tetris.gb"), DeployItem(b, "roms/gb/Tetris.gb")], sd)
+    assert not list(sd.iterdir())
@@ -0,0 +1,241 @@
+from packer.discovery.detect import discover_roms, iter_roms
+
+GB = "Nintendo - Game Boy"
+SNES = "Nintendo - Super Nintendo Entertainment System"
+
+
+def _touch(path):
+    path.parent.mkdir(parents=True, exist_ok=True)
+    path.write_bytes(b"\0")
+
+
+def test_nested_platform_folders_respect_depth(tmp_path):
+    _touch(tmp_path / "gb" / "T" / "Tetris (World).gb")
+    _touch(tmp_path / "gb" / "Alleyway.gb")
+    _touch(tmp_path / "gb" / "a" / "b" / "Deep.gb")
+    _touch(tmp_path / "gb" / ".hidden" / "Skip.gb")
+    _touch(tmp_path / "gb" / "notes.txt")
+    _touch(tmp_path / "snes" / "S" / "Super Metroid.sfc")
+    _touch(tmp_path / "unknown folder" / "x.gb")
+
+    names = [(p, r.name) for p, r in discover_roms(tmp_path, max_depth=1)]
+    assert names == [
+        (GB, "Alleyway.gb"),
+        (GB, "Tetris (World).gb"),
+        (SNES, "Super Metroid.sfc"),
+    ]
+    assert (GB, "Deep.gb") in [(p, r.name) for p, r in discover_roms(tmp_path)]
+    assert [r.name for _, r in discover_roms(tmp_path, max_depth=0)] == ["Alleyway.gb"]
+
+
+def test_flat_files_and_missing_root(tmp_path):
+    _touch(tmp_path / "Flat.sfc")
+    assert discover_roms(tmp_path) == [(SNES, tmp_path / "Flat.sfc")]
+    assert list(iter_roms(tmp_path / "missing")) == []
+
+
+def test_cache_reuses_unchanged_directories(tmp_path):
+    import os
+    from packer.discovery.cache import DiscoveryCache
+
+    roms = tmp_path / "roms"
+    _touch(roms / "gb" / "T" / "Tetris.gb")
+    _touch(roms / "snes" / "Super Metroid.sfc")
+    old = 1_000_000_000
+    for d in (roms, roms / "gb", roms / "gb" / "T", roms / "snes"):
+        os.utime(d, (old, old))
+
+    cache = DiscoveryCache.for_root(roms, cache_dir=tmp_path / "cache")
+    first = discover_roms(roms, cache=cache)
+    cache.save()
+    assert cache.misses == 4
+
+    cache = DiscoveryCache.for_root(roms, cache_dir=tmp_path / "cache")
+    assert discover_roms(roms, cache=cache) == first
+    assert (cache.hits, cache.misses) == (4, 0)
+
+    _touch(roms / "gb" / "T" / "Tennis.gb")     # bumps gb/T's mtime only
+    cache = DiscoveryCache.for_root(roms, cache_dir=tmp_path / "cache")
+    assert [r.name for _, r in discover_roms(roms, cache=cache)] == ["Tennis.gb", "Tetris.gb", "Super Metroid.sfc"]
+    assert (cache.hits, cache.misses) == (3, 1)
+
+
+def test_cache_rechecks_rows_classified_from_contents(tmp_path):
+    import os
+    from packer.discovery.cache import DiscoveryCache
+
+    psx = tmp_path / "roms" / "psx"
+    (psx / "discs").mkdir(parents=True)
+    (psx / "Game.cue").write_text('FILE "discs/Game.bin" BINARY\n')
+    _touch(psx / "discs" / "Game.bin")
+    _touch(psx / "discs" / "Other.bin")
+    old = 1_000_000_000
+    for d in (tmp_path / "roms", psx, psx / "discs"):
+        os.utime(d, (old, old))
+
+    def _scan():
+        cache = DiscoveryCache.for_root(tmp_path / "roms", cache_dir=tmp_path / "cache")
+        found = [r.name for _, r in discover_roms(tmp_path / "roms", cache=cache)]
+        cache.save()
+        return found, cache.misses
+
+    assert _scan() == (["Game.cue"], 3)
+    assert _scan() == (["Game.cue"], 0)
+
+    # Edited in place, pointing at another track: psx's mtime is unchanged
+    (psx / "Game.cue").write_text('FILE "discs/Other.bin" BINARY\n')
+    os.utime(psx, (old, old))
+    assert _scan() == (["Game.cue"], 1)
+
+    # The referenced track moves away inside discs/: only that folder's mtime changes
+    (psx / "discs" / "Other.bin").rename(psx / "discs" / "Moved.bin")
+    os.utime(psx, (old, old))
+    assert _scan() == ([], 2)
+
+
+def test_signature_parameters_invalidate_the_cache(monkeypatch):
+    from packer.discovery import cache, systems
+
+    nes = "Nintendo - Nintendo Entertainment System"
+    monkeypatch.setattr(systems, "HEADER_SIGNATURES", [systems.HeaderSignature(nes, systems.magic_at(0, b"NES"))])
+    monkeypatch.setattr(cache, "HEADER_SIGNATURES", systems.HEADER_SIGNATURES)
+    before = cache._rules_fingerprint()
+    systems.HEADER_SIGNATURES[0] = systems.HeaderSignature(nes, systems.magic_at(4, b"NES"))
+    assert cache._rules_fingerprint() != before
+
+
+def test_header_sniffing_for_shared_extensions(tmp_path):
+    import struct
+    from packer.discovery.systems import sniff_platform
+
+    nes = tmp_path / "a.bin"
+    nes.write_bytes(b"NES\x1a" + bytes(0x4000))
+    genesis = tmp_path / "b.bin"
+    genesis.write_bytes(bytes(0x100) + b"SEGA MEGA DRIVE " + bytes(0x100))
+    snes = bytearray(0x8000)
+    struct.pack_into("<HH", snes, 0x7FDC, 0x1234 ^ 0xFFFF, 0x1234)
+    (tmp_path / "c.bin").write_bytes(bytes(0x200) + snes)          # with copier header
+    (tmp_path / "d.bin").write_bytes(bytes(64))
+
+    candidates = {NES := "Nintendo - Nintendo Entertainment System", "Sega - Mega Drive - Genesis", SNES}
+    assert sniff_platform(nes, candidates) == NES
+    assert sniff_platform(genesis, candidates) == "Sega - Mega Drive - Genesis"
+    assert sniff_platform(tmp_path / "c.bin", candidates) == SNES
+    assert sniff_platform(tmp_path / "d.bin", candidates) is None
+    assert sniff_platform(nes, {"Sega - Mega Drive - Genesis"}) is None
+
+
+def test_flat_shared_extension_is_sniffed(tmp_path, monkeypatch):
+    from packer.discovery import detect
+
+    nes = "Nintendo - Nintendo Entertainment System"
+    monkeypatch.setitem(detect.EXT_TO_PLAT, ".bin", {nes, "Sega - Mega Drive - Genesis"})
+    (tmp_path / "Zelda.bin").write_bytes(b"NES\x1a" + bytes(16))
+    (tmp_path / "Mystery.bin").write_bytes(bytes(16))
+    assert discover_roms(tmp_path) == [(nes, tmp_path / "Zelda.bin")]
+
+
+def test_flat_bin_needs_a_genesis_header(tmp_path, capsys):
+    (tmp_path / "Sonic.bin").write_bytes(bytes(0x100) + b"SEGA GENESIS    " + bytes(0x100))
+    (tmp_path / "Stray.bin").write_bytes(bytes(0x300))
+    assert discover_roms(tmp_path) == [("Sega - Mega Drive - Genesis", tmp_path / "Sonic.bin")]
+    assert "Stray.bin: no known header" in capsys.readouterr().out
+
+
+def test_zipped_roms_are_found_and_streamed(tmp_path):
+    import zipfile
+    import zlib
+    from packer.io.archive import copy_rom, open_rom, rom_stat
+    from packer.io.hashing import hash_one
+
+    data = b"\x01\x02" * 40_000
+    (tmp_path / "snes").mkdir()
+    with zipfile.ZipFile(tmp_path / "snes" / "Zipped.zip", "w", zipfile.ZIP_DEFLATED) as zf:
+        zf.writestr("readme.txt", "x")
+        zf.writestr("Zipped (USA).sfc", data)
+    with zipfile.ZipFile(tmp_path / "Flat.zip", "w") as zf:
+        zf.writestr("Flat.gba", data)
+    with zipfile.ZipFile(tmp_path / "snes" / "Other.zip", "w") as zf:
+        zf.writestr("Other.gba", data)
+    (tmp_path / "snes" / "Broken.zip").write_bytes(b"not a zip")
+
+    found = discover_roms(tmp_path)
+    assert found == [
+        ("Nintendo - Game Boy Advance", tmp_path / "Flat.zip" / "Flat.gba"),
+        (SNES, tmp_path / "snes" / "Zipped.zip" / "Zipped (USA).sfc"),
+    ]
+    member = found[1][1]
+    assert member.name == "Zipped (USA).sfc"
+    assert rom_stat(member).st_size == len(data)
+    with open_rom(member) as f:
+        assert f.read() == data
+    assert hash_one(member).crc32 == zlib.crc32(data)
+    copy_rom(member, tmp_path / "out.sfc")
+    assert (tmp_path / "out.sfc").read_bytes() == data
+
+
+def test_disc_sets_become_single_titles(tmp_path):
+    from packer.discovery.discsets import disc_set
+
+    ps1 = tmp_path / "psx"
+    _touch(ps1 / "Single.cue")
+    (ps1 / "Single.cue").write_text('FILE "Single (Track 1).bin" BINARY\nFILE "single (track 2).BIN" BINARY\n')
+    _touch(ps1 / "Single (Track 1).bin")
+    _touch(ps1 / "Single (Track 2).bin")
+    (ps1 / "Broken.cue").write_text('FILE "Missing.bin" BINARY\n')
+    (ps1 / "Multi.m3u").write_text("#EXTM3U\ndiscs/Multi (Disc 1).cue\ndiscs/Multi (Disc 2).cue\n")
+    for n in (1, 2):
+        _touch(ps1 / "discs" / f"Multi (Disc {n}).bin")
+        (ps1 / "discs" / f"Multi (Disc {n}).cue").write_text(f"FILE \"Multi (Disc {n}).bin\" BINARY\n")
+
+    found = discover_roms(tmp_path)
+    assert [r.name for _, r in found] == ["Multi.m3u", "Single.cue"]
+    assert {p for p, _ in found} == {"Sony - PlayStation"}
+    assert [rel for _, rel in disc_set(found[0][1])] == [
+        "Multi.m3u",
+        "discs/Multi (Disc 1).cue",
+        "discs/Multi (Disc 2).cue",
+        "discs/Multi (Disc 1).bin",
+        "discs/Multi (Disc 2).bin",
+    ]
+    assert [rel for _, rel in disc_set(found[1][1])] == [
+        "Single.cue", "Single (Track 1).bin", "Single (Track 2).bin",
+    ]
+
+
+def test_flat_cue_with_ambiguous_platform_is_skipped_whole(tmp_path, capsys):
+    (tmp_path / "Game.cue").write_text('FILE "Game (Track 1).bin" BINARY\n')
+    _touch(tmp_path / "Game (Track 1).bin")
+    _touch(tmp_path / "Tetris.gb")
+
+    assert discover_roms(tmp_path) == [(GB, tmp_path / "Tetris.gb")]
+    assert "Game.cue: could be" in capsys.readouterr().out
+
+
+def test_packerignore_and_patterns_prune_folders(tmp_path, monkeypatch):
+    from packer.discovery import detect
+    from packer.discovery.ignore import PathFilter
+
+    _touch(tmp_path / "gb" / "Tetris (USA).gb")
+    _touch(tmp_path / "gb" / "Hack.gb")
+    _touch(tmp_path / "gb" / "bios" / "gb_bios.gb")
+    _touch(tmp_path / "gb" / "hacks" / "Keep.gb")
+    _touch(tmp_path / "gb" / "hacks" / "Drop.gb")
+    _touch(tmp_path / "snes" / "Mario (USA).sfc")
+    _touch(tmp_path / "snes" / "Mario (Japan).sfc")
+    (tmp_path / ".packerignore").write_text("# root rules\nbios/\nHack.gb\n")
+    (tmp_path / "gb" / "hacks" / ".packerignore").write_text("*.gb\n!Keep.gb\n")
+
+    listed = []
+    scan = detect._scan_dir
+    monkeypatch.setattr(detect, "_scan_dir", lambda d, *a, **k: listed.append(d) or scan(d, *a, **k))
+
+    names = sorted(r.name for _, r in discover_roms(tmp_path))
+    assert names == ["Keep.gb", "Mario (Japan).sfc", "Mario (USA).sfc", "Tetris (USA).gb"]
+    assert str(tmp_path / "gb" / "bios") not in listed
+
+    listed.clear()
+    filt = PathFilter(exclude=["snes/"], include=["*(USA)*", "gb/hacks/**"])
+    names = sorted(r.name for _, r in discover_roms(tmp_path, path_filter=filt))
+    assert names == ["Keep.gb", "Tetris (USA).gb"]
+    assert str(tmp_path / "snes") not in listed
@@ -0,0 +1,28 @@
+import hashlib
+import os
+import zlib
+
+from packer.io.hashing import HashCache, hash_files, hash_one
+
+
+def test_hashes_are_cached_by_stat(tmp_path):
+    data = os.urandom(200_000)
+    rom = tmp_path / "a.gba"
+    rom.write_bytes(data)
+
+    with HashCache(tmp_path / "hashes.sqlite") as cache:
+        h = hash_files([rom, tmp_path / "missing.gba"], cache)[rom]
+        assert h.size == len(data)
+        assert h.crc32 == zlib.crc32(data)
+        assert h.sha1 == hashlib.sha1(data).hexdigest()
+        assert cache.misses == 1
+
+    with HashCache(tmp_path / "hashes.sqlite") as cache:
+        assert hash_one(rom, cache) == h
+        assert (cache.hits, cache.misses) == (1, 0)
+
+        rom.write_bytes(data[:-1])
+        st = rom.stat()
+        os.utime(rom, ns=(st.st_atime_ns, st.st_mtime_ns + 1_000_000_000))
+        assert hash_one(rom, cache).size == len(data) - 1
+        assert cache.misses == 1
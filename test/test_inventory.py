@@ -0,0 +1,39 @@
+import json
+
+from packer.build.cores import CoreMap
+from packer.build.inventory import installed_core_candidates, load_sd_inventory
+
+CORE_MAP = CoreMap(
+    default_core_dir="sdmc:/switch/retroarch/cores",
+    platforms={
+        "Nintendo - Super Nintendo Entertainment System": [
+            "snes9x2010_libretro_libnx.so",
+            "snes9x_libretro_libnx.so",
+        ],
+        "Nintendo - Game Boy": ["gambatte_libretro_libnx.so"],
+    },
+)
+
+
+def test_mounted_sd_picks_first_present_core(tmp_path):
+    cores = tmp_path / "switch" / "retroarch" / "cores"
+    cores.mkdir(parents=True)
+    (cores / "snes9x_libretro_libnx.so").write_bytes(b"")
+    (tmp_path / "switch" / "retroarch_switch.nro").write_bytes(b"")
+
+    inv = load_sd_inventory(tmp_path, CORE_MAP)
+    assert installed_core_candidates("snes", CORE_MAP, inv) == [
+        "sdmc:/switch/retroarch/cores/snes9x_libretro_libnx.so"
+    ]
+    assert installed_core_candidates("gb", CORE_MAP, inv) == []
+    assert inv.has("sdmc:/switch/retroarch_switch.nro")
+    assert not inv.has("sdmc:/switch/retroarch/retroarch_switch.nro")
+
+
+def test_json_listing_is_case_insensitive(tmp_path):
+    listing = tmp_path / "inventory.json"
+    listing.write_text(json.dumps({"files": ["sdmc:/switch/retroarch/cores/Gambatte_libretro_libnx.so"]}))
+    inv = load_sd_inventory(listing, CORE_MAP)
+    assert installed_core_candidates("Nintendo - Game Boy", CORE_MAP, inv) == [
+        "sdmc:/switch/retroarch/cores/gambatte_libretro_libnx.so"
+    ]
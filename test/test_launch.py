@@ -0,0 +1,38 @@
+import struct
+
+import pytest
+
+from packer.build.launch import (
+    LAUNCH_FLAG_TRACE,
+    LAUNCH_HEADER_SIZE,
+    LaunchDescriptor,
+    decode_launch,
+    encode_launch,
+)
+
+
+def test_launch_roundtrip_keeps_long_argv():
+    rom = "sdmc:/roms/Sony - PlayStation/" + "Long Title " * 100 + "(USA).cue"
+    desc = LaunchDescriptor(
+        target="sdmc:/switch/retroarch/retroarch_switch.nro",
+        argv=["-L", "sdmc:/switch/retroarch/cores/pcsx_rearmed_libretro_libnx.so", rom],
+        fallbacks=["sdmc:/switch/retroarch_switch.nro"],
+        flags=LAUNCH_FLAG_TRACE,
+        cores=[
+            "sdmc:/switch/retroarch/cores/pcsx_rearmed_libretro_libnx.so",
+            "sdmc:/switch/retroarch/cores/mednafen_psx_libretro_libnx.so",
+        ],
+        core_arg=1,
+    )
+    data = encode_launch(desc)
+    assert data[:4] == b"SRPL"
+    assert struct.unpack_from("<I", data, 8)[0] == len(data)
+    assert len(data) > LAUNCH_HEADER_SIZE + len(rom)
+    assert decode_launch(data) == desc
+
+
+def test_launch_rejects_quotes_and_bad_core_arg():
+    with pytest.raises(ValueError):
+        encode_launch(LaunchDescriptor(target="sdmc:/a.nro", argv=['say "hi"']))
+    with pytest.raises(ValueError):
+        encode_launch(LaunchDescriptor(target="sdmc:/a.nro", argv=["rom"], cores=["a.so"], core_arg=1))
@@ -0,0 +1,40 @@
+import struct
+import zlib
+
+from packer.io.filelist import (
+    MANIFEST_ENTRY_SIZE,
+    MANIFEST_HEADER_SIZE,
+    ManifestEntry,
+    decode_manifest,
+    decode_manifest_dirs,
+    encode_manifest,
+    manifest_entry_for_file,
+)
+
+
+def test_manifest_roundtrip_keeps_long_paths():
+    long_name = "A" * 900 + ".sfc"
+    entries = [
+        ManifestEntry(platform="Nintendo - Super Nintendo Entertainment System", src=long_name, size=3, crc32=1),
+        ManifestEntry(platform="Sega - Mega Drive - Genesis", src="x.md", size=5, crc32=2, dest="/roms/custom/x.md"),
+    ]
+    data = encode_manifest(entries)
+    assert data[:4] == b"SRPM"
+    assert struct.unpack_from("<I", data, 8)[0] == 2
+    assert len(data) >= MANIFEST_HEADER_SIZE + 2 * MANIFEST_ENTRY_SIZE
+    assert decode_manifest(data) == entries
+    assert decode_manifest_dirs(data) == [
+        "/roms",
+        "/roms/Nintendo - Super Nintendo Entertainment System",
+        "/roms/custom",
+    ]
+
+
+def test_manifest_entry_for_file_streams_crc(tmp_path):
+    payload = b"\x00\x01rom-bytes" * 1000
+    rom = tmp_path / "game.nes"
+    rom.write_bytes(payload)
+    e = manifest_entry_for_file("Nintendo - Nintendo Entertainment System", rom)
+    assert e.src == "game.nes"
+    assert e.size == len(payload)
+    assert e.crc32 == zlib.crc32(payload)
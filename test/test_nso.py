@@ -0,0 +1,64 @@
+import hashlib
+import os
+import struct
+
+import pytest
+
+from packer.build.nso import (
+    LAUNCH_EMBED_SIZE,
+    LAUNCH_EMBED_TAG,
+    lz4_block_compress,
+    lz4_block_decompress,
+    patch_nso_launch,
+    read_nso_launch,
+)
+
+
+def _make_nso(ro: bytes, compress: bool) -> bytes:
+    text, data = b"\x1f\x20\x03\xd5" * 64, b"DATA" * 16
+    segs = [text, lz4_block_compress(ro) if compress else ro, data]
+    sizes = [len(text), len(ro), len(data)]
+    header = bytearray(0x100)
+    header[0:4] = b"NSO0"
+    struct.pack_into("<I", header, 0x0C, 0b010 if compress else 0)
+    off, mem = 0x100, 0
+    for i, body in enumerate(segs):
+        struct.pack_into("<III", header, 0x10 + 0x10 * i, off, mem, sizes[i])
+        struct.pack_into("<I", header, 0x60 + 4 * i, len(body))
+        off += len(body)
+        mem += sizes[i]
+    return bytes(header) + b"".join(segs)
+
+
+def _rodata() -> bytes:
+    slot = LAUNCH_EMBED_TAG + bytes(16) + bytes(LAUNCH_EMBED_SIZE)
+    return b"some strings\0" * 50 + slot + os.urandom(300) + b"tail" * 10
+
+
+def test_lz4_roundtrip():
+    src = b"abcabcabcabc" * 500 + os.urandom(1000) + bytes(5000)
+    assert lz4_block_decompress(lz4_block_compress(src), len(src)) == src
+
+
+@pytest.mark.parametrize("compress", [False, True])
+def test_patch_nso_embeds_descriptor(compress):
+    nso = _make_nso(_rodata(), compress)
+    assert read_nso_launch(nso) is None
+
+    patched = patch_nso_launch(nso, b"SRPL-descriptor")
+    assert read_nso_launch(patched) == b"SRPL-descriptor"
+
+    # text/data untouched, ro hash matches the decompressed segment
+    assert patched[0x100:0x100 + 256] == nso[0x100:0x100 + 256]
+    ro_off, _, ro_size = struct.unpack_from("<III", patched, 0x20)
+    ro_file = patched[ro_off:ro_off + struct.unpack_from("<I", patched, 0x64)[0]]
+    ro = lz4_block_decompress(ro_file, ro_size) if compress else ro_file
+    assert patched[0xC0:0xE0] == hashlib.sha256(ro).digest()
+    assert patched.endswith(b"DATA" * 16)
+
+
+def test_patch_nso_rejects_missing_slot_and_oversize():
+    with pytest.raises(ValueError):
+        patch_nso_launch(_make_nso(b"no slot here" * 10, False), b"x")
+    with pytest.raises(ValueError):
+        patch_nso_launch(_make_nso(_rodata(), False), bytes(LAUNCH_EMBED_SIZE + 1))
@@ -0,0 +1,47 @@
+import json
+
+from packer.build.playlist import PlaylistEntry, write_playlists
+
+GB = "Nintendo - Game Boy"
+
+
+def test_playlists_per_platform(tmp_path):
+    entries = [
+        PlaylistEntry(GB, f"/roms/{GB}/Tetris (World).gb", "Tetris", 0x46DF91AD,
+                      "sdmc:/switch/retroarch/cores/gambatte_libretro_libnx.so"),
+        PlaylistEntry(GB, f"/roms/{GB}/Alleyway (World).gb", "Alleyway", 0x1C, None),
+        PlaylistEntry("Sega - Game Gear", "/roms/Sega - Game Gear/Columns.gg", "Columns"),
+    ]
+    written = write_playlists(tmp_path, entries)
+    assert sorted(p.name for p in written) == ["Nintendo - Game Boy.lpl", "Sega - Game Gear.lpl"]
+
+    doc = json.loads((tmp_path / "Nintendo - Game Boy.lpl").read_text(encoding="utf-8"))
+    assert doc["version"] == "1.5"
+    first, second = doc["items"]
+    assert first["label"] == "Alleyway"
+    assert first["core_path"] == "DETECT" and first["crc32"] == "0000001C|crc"
+    assert second["path"] == "/roms/Nintendo - Game Boy/Tetris (World).gb"
+    assert second["core_path"] == "/switch/retroarch/cores/gambatte_libretro_libnx.so"
+    assert second["core_name"] == "gambatte"
+    assert second["crc32"] == "46DF91AD|crc"
+    assert second["db_name"] == "Nintendo - Game Boy.lpl"
+
+
+def test_playlist_without_crc(tmp_path):
+    write_playlists(tmp_path, [PlaylistEntry(GB, f"/roms/{GB}/a.gb", "A", 1)], with_crc=False)
+    doc = json.loads((tmp_path / f"{GB}.lpl").read_text(encoding="utf-8"))
+    assert doc["items"][0]["crc32"] == "DETECT"
+
+
+def test_label_matching_only_when_every_entry_has_a_dat_name(tmp_path):
+    dat = PlaylistEntry(GB, f"/roms/{GB}/tetris.gb", "Tetris (World) (Rev 1)", thumbnail="Tetris (World) (Rev 1)")
+    plain = PlaylistEntry(GB, f"/roms/{GB}/USA/Alleyway (World).gb", "Alleyway")
+
+    write_playlists(tmp_path, [dat, plain])
+    doc = json.loads((tmp_path / f"{GB}.lpl").read_text(encoding="utf-8"))
+    assert doc["thumbnail_match_mode"] == 1
+    assert [it["label"] for it in doc["items"]] == ["Alleyway", "Tetris (World) (Rev 1)"]
+
+    write_playlists(tmp_path, [dat])
+    doc = json.loads((tmp_path / f"{GB}.lpl").read_text(encoding="utf-8"))
+    assert doc["thumbnail_match_mode"] == 0 and doc["items"][0]["label"] == "Tetris (World) (Rev 1)"
@@ -0,0 +1,68 @@
+import json
+import threading
+import urllib.error
+import urllib.request
+
+import pytest
+
+from packer.io.serve import make_server, parse_range
+
+
+@pytest.fixture
+def served(tmp_path):
+    (tmp_path / "nsp").mkdir()
+    payload = bytes(range(256)) * 40
+    (tmp_path / "nsp" / "Super Game [05ABCDEF01234567].nsp").write_bytes(payload)
+    (tmp_path / "secret.txt").write_text("no")
+    server = make_server(tmp_path, host="127.0.0.1", port=0)
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    yield f"http://127.0.0.1:{server.server_address[1]}", payload
+    server.shutdown()
+    server.server_close()
+
+
+def _get(url, headers=None):
+    with urllib.request.urlopen(urllib.request.Request(url, headers=headers or {})) as r:
+        return r.status, dict(r.headers), r.read()
+
+
+def test_index_and_range_requests(served):
+    base, payload = served
+    _, _, body = _get(base + "/index.json")
+    index = json.loads(body)
+    assert index["titles"][0]["title_id"] == "05ABCDEF01234567"
+    assert index["files"][0]["size"] == len(payload)
+    url = base + index["files"][0]["url"]
+
+    status, _, body = _get(url)
+    assert status == 200 and body == payload
+
+    status, headers, body = _get(url, {"Range": "bytes=100-199"})
+    assert status == 206 and body == payload[100:200]
+    assert headers["Content-Range"] == f"bytes 100-199/{len(payload)}"
+
+    _, _, body = _get(url, {"Range": "bytes=-10"})
+    assert body == payload[-10:]
+
+    status, _, body = _get(url, {"Range": "bytes=5-3"})
+    assert status == 200 and body == payload
+
+    with pytest.raises(urllib.error.HTTPError) as e:
+        _get(url, {"Range": f"bytes={len(payload)}-"})
+    assert e.value.code == 416
+    for bad in ("/secret.txt", "/../etc/passwd"):
+        with pytest.raises(urllib.error.HTTPError):
+            _get(base + bad)
+
+
+def test_parse_range():
+    assert parse_range(None, 10) is None
+    assert parse_range("bytes=2-", 10) == (2, 9)
+    assert parse_range("bytes=5-100", 10) == (5, 9)
+    assert parse_range("bytes=0-1,4-5", 10) is None
+    assert parse_range("bytes=5-3", 10) is None         # invalid: ignored, whole file
+    assert parse_range("bytes=-4", 10) == (6, 9)
+    with pytest.raises(ValueError):
+        parse_range("bytes=-4", 0)                     # no bytes to suffix
+    with pytest.raises(ValueError):
+        parse_range("bytes=10-", 10)
@@ -0,0 +1,143 @@
+"""Aggregate boot-stage trace records written by the forwarder and the stub.
+
+Both components append fixed-size records (see common/include/boottrace.h) to
+sdmc:/switch-rom-packer/boot-trace.bin when built with TRACE=1. Point this
+script at that file, a copy of it, or a directory holding several copies
+(e.g. a mounted SD card) to get per-stage and per-title latency figures.
+"""
+from pathlib import Path
+import argparse
+import json
+import statistics
+import struct
+import sys
+
+RECORD = struct.Struct("<4sHBBQQ12III")
+MAGIC = b"SRPT"
+TRACE_NAME = "boot-trace.bin"
+
+COMPONENTS = {0: "forwarder", 1: "stub"}
+
+# Stage order per component; keep in sync with common/include/boottrace.h.
+STAGES = {
+    "forwarder": ["fs_init", "sdmc_mount", "romfs_init", "read_params", "stat_target", "handoff"],
+    "stub": ["console_init", "romfs_init", "manifest_load", "manifest_validate", "extract"],
+}
+
+
+def read_records(path: Path):
+    """Yield one dict per valid record; stops at the first corrupt or short record."""
+    data = path.read_bytes()
+    for off in range(0, len(data) - RECORD.size + 1, RECORD.size):
+        magic, version, component, count, program_id, start_tick, *rest = RECORD.unpack_from(data, off)
+        if magic != MAGIC or version != 1:
+            print(f"[WARN] {path}: bad record at offset {off}, ignoring the rest", file=sys.stderr)
+            return
+        stage_us, status = rest[:12], rest[12]
+        name = COMPONENTS.get(component, f"component{component}")
+        labels = STAGES.get(name, [])
+        stages = {
+            (labels[i] if i < len(labels) else f"s{i}"): stage_us[i]
+            for i in range(min(count, len(stage_us)))
+        }
+        yield {
+            "component": name,
+            "program_id": f"{program_id:016X}",
+            "start_tick": start_tick,
+            "status": status,
+            "stages": stages,
+            "total_us": sum(stages.values()),
+        }
+
+
+def find_traces(paths):
+    for p in paths:
+        p = Path(p)
+        if p.is_dir():
+            yield from sorted(p.rglob(TRACE_NAME))
+        elif p.is_file():
+            yield p
+        else:
+            print(f"[WARN] {p}: not found", file=sys.stderr)
+
+
+def percentile(values, pct):
+    ordered = sorted(values)
+    k = max(0, min(len(ordered) - 1, round(pct / 100 * (len(ordered) - 1))))
+    return ordered[k]
+
+
+def summarize(values):
+    return {
+        "n": len(values),
+        "median_us": int(statistics.median(values)),
+        "p90_us": percentile(values, 90),
+        "max_us": max(values),
+    }
+
+
+def build_report(records):
+    report = {}
+    for comp in sorted({r["component"] for r in records}):
+        recs = [r for r in records if r["component"] == comp]
+        stages = {}
+        for label in STAGES.get(comp, []) + sorted({k for r in recs for k in r["stages"]} - set(STAGES.get(comp, []))):
+            values = [r["stages"][label] for r in recs if label in r["stages"]]
+            if values:
+                stages[label] = summarize(values)
+        titles = {}
+        for r in recs:
+            titles.setdefault(r["program_id"], []).append(r)
+        report[comp] = {
+            "launches": len(recs),
+            "failures": sum(1 for r in recs if r["status"]),
+            "total": summarize([r["total_us"] for r in recs]),
+            "stages": stages,
+            "titles": {
+                tid: dict(summarize([r["total_us"] for r in rs]), failures=sum(1 for r in rs if r["status"]))
+                for tid, rs in sorted(titles.items())
+            },
+        }
+    return report
+
+
+def print_report(report, top):
+    for comp, data in report.items():
+        print(f"== {comp}: {data['launches']} launches, {data['failures']} failed ==")
+        print(f"{'stage':<20}{'n':>6}{'median ms':>12}{'p90 ms':>10}{'max ms':>10}")
+        rows = list(data["stages"].items()) + [("total", data["total"])]
+        for label, s in rows:
+            print(f"{label:<20}{s['n']:>6}{s['median_us'] / 1000:>12.2f}"
+                  f"{s['p90_us'] / 1000:>10.2f}{s['max_us'] / 1000:>10.2f}")
+        slowest = sorted(data["titles"].items(), key=lambda kv: kv[1]["median_us"], reverse=True)[:top]
+        if slowest:
+            print("\nslowest titles (median total):")
+            for tid, s in slowest:
+                fail = f", {s['failures']} failed" if s["failures"] else ""
+                print(f"  {tid}  {s['median_us'] / 1000:8.2f} ms  ({s['n']} launches{fail})")
+        print()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("paths", nargs="+", help=f"{TRACE_NAME} files or directories to search")
+    ap.add_argument("--json", dest="json_out", default=None, help="Also write the report as JSON")
+    ap.add_argument("--top", type=int, default=10, help="Number of slowest titles to list")
+    args = ap.parse_args()
+
+    records = [r for p in find_traces(args.paths) for r in read_records(p)]
+    if not records:
+        print("No boot trace records found.", file=sys.stderr)
+        sys.exit(1)
+
+    report = build_report(records)
+    print_report(report, args.top)
+    if args.json_out:
+        out = Path(args.json_out)
+        out.parent.mkdir(parents=True, exist_ok=True)
+        out.write_text(json.dumps(report, indent=2), encoding="utf-8")
+        print(f"Wrote {out}")
+
+
+if __name__ == "__main__":
+    main()